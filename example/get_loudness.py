@@ -3,6 +3,8 @@ This example script shows how to interact with loudness-dock plugin through obs-
 '''
 
 import argparse
+import base64
+import struct
 import obsws_python
 
 
@@ -12,8 +14,32 @@ def _get_args():
     parser.add_argument('-p', '--pause', action='store_true')
     parser.add_argument('-s', '--resume', action='store_true')
     parser.add_argument('--name', action='store', default=None)
+    parser.add_argument('--history', action='store', type=int, default=None,
+                        help='Print the momentary and short-term loudness of the last seconds')
+    parser.add_argument('--decimate', action='store', type=int, default=10)
+    parser.add_argument('--all', action='store_true', help='Print the loudness of all the tabs')
+    parser.add_argument('--fields', action='store', default=None,
+                        help='Comma-separated fields to print with --all')
     return parser.parse_args()
 
+def _decode_history(data, no_value):
+    values = struct.unpack(f'<{len(data) // 2}h', base64.b64decode(data))
+    return [float('-inf') if v == no_value else v / 100.0 for v in values]
+
+def _print_history(cl, data, seconds, decimate):
+    res = cl.send('CallVendorRequest', {
+        'vendorName': 'loudness-dock',
+        'requestType': 'get_history',
+        'requestData': data | {'since': -seconds * 1000, 'decimate': decimate},
+    })
+    r = res.response_data
+    for seg in r['segments']:
+        momentary = _decode_history(seg['momentary'], r['no_value'])
+        short = _decode_history(seg['short'], r['no_value'])
+        for i in range(seg['count']):
+            t = (seg['start'] + i * r['interval'] - r['now']) / 1000.0
+            print(f'{t:8.1f} s: momentary {momentary[i]:6.1f} short {short[i]:6.1f}')
+
 def _main():
     args = _get_args()
 
@@ -44,7 +70,19 @@ def _main():
             'requestData': data | {'pause': False},
         })
 
-    if not (args.pause or args.resume or args.reset):
+    if args.history:
+        _print_history(cl, data, args.history, args.decimate)
+
+    if args.all:
+        res = cl.send('CallVendorRequest', {
+            'vendorName': 'loudness-dock',
+            'requestType': 'get_all',
+            'requestData': {'fields': args.fields} if args.fields else {},
+        })
+        for tab in res.response_data['tabs']:
+            print(' '.join(f'{k}: {v}' for k, v in tab.items()))
+
+    if not (args.pause or args.resume or args.reset or args.history or args.all):
         res = cl.send('CallVendorRequest', {
             'vendorName': 'loudness-dock',
             'requestType': 'get_loudness',
@@ -55,6 +93,8 @@ def _main():
             if value is None:
                 value = float('-inf')
             print(f'{field}: {value:.1f}')
+        if 'peak_mode' in res.response_data:
+            print(f'peak_mode: {res.response_data["peak_mode"]}')
 
 
 if __name__ == '__main__':
@@ -8,7 +8,6 @@ Source0: %{name}-%{version}.tar.bz2
 BuildRequires: cmake, gcc, gcc-c++
 BuildRequires: obs-studio-devel
 BuildRequires: qt6-qtbase-devel qt6-qtbase-private-devel
-BuildRequires: libebur128-devel
 
 %description
 This is a plugin for OBS Studio to provide a dock window displaying EBU R 128 loudness meter.
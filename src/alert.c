@@ -0,0 +1,204 @@
+/*
+Loudness Dock for OBS Studio
+Copyright (C) 2025 Norihiro Kamae <norihiro@nagater.net>
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#include <math.h>
+#include <obs-module.h>
+#include "alert.h"
+#include "plugin-macros.generated.h"
+
+struct alert_state
+{
+	struct alert_rule rule;
+	uint32_t attack_blocks;
+	uint32_t release_blocks;
+
+	/* Blocks in a row that the condition differs from `active` */
+	uint32_t count;
+	bool active;
+	double value;
+};
+
+struct alert_set
+{
+	char *tab;
+	alert_cb_t cb;
+	void *param;
+	bool armed;
+
+	size_t n;
+	struct alert_state states[];
+};
+
+static uint32_t blocks_from_seconds(double seconds)
+{
+	if (!(seconds > 0.1))
+		return 1;
+	return (uint32_t)(seconds * 10.0 + 0.5);
+}
+
+alert_set_t *alert_set_create(const char *tab, const struct alert_rule *rules, size_t n, alert_cb_t cb, void *param)
+{
+	alert_set_t *s = bzalloc(sizeof(alert_set_t) + sizeof(struct alert_state) * n);
+	s->tab = bstrdup(tab);
+	s->cb = cb;
+	s->param = param;
+	s->armed = true;
+	s->n = n;
+
+	for (size_t i = 0; i < n; i++) {
+		struct alert_state *st = &s->states[i];
+		st->rule = rules[i];
+		st->rule.name = bstrdup(rules[i].name);
+		st->attack_blocks = blocks_from_seconds(rules[i].duration);
+		st->release_blocks = st->attack_blocks > ALERT_RELEASE_BLOCKS ? st->attack_blocks : ALERT_RELEASE_BLOCKS;
+		st->value = -HUGE_VAL;
+	}
+
+	return s;
+}
+
+void alert_set_destroy(alert_set_t *s)
+{
+	if (!s)
+		return;
+
+	for (size_t i = 0; i < s->n; i++)
+		bfree((char *)s->states[i].rule.name);
+	bfree(s->tab);
+	bfree(s);
+}
+
+static bool str_equals(const char *a, const char *b)
+{
+	return strcmp(a ? a : "", b ? b : "") == 0;
+}
+
+bool alert_set_equals(const alert_set_t *s, const char *tab, const struct alert_rule *rules, size_t n, alert_cb_t cb,
+		      void *param)
+{
+	if (s->n != n || s->cb != cb || s->param != param || !str_equals(s->tab, tab))
+		return false;
+
+	for (size_t i = 0; i < n; i++) {
+		const struct alert_rule *a = &s->states[i].rule;
+		const struct alert_rule *b = &rules[i];
+		if (!str_equals(a->name, b->name) || a->condition != b->condition || a->threshold != b->threshold ||
+		    a->tolerance != b->tolerance || a->duration != b->duration)
+			return false;
+	}
+
+	return true;
+}
+
+static void emit(const alert_set_t *s, const struct alert_state *st)
+{
+	blog(LOG_INFO, "Alert '%s' of tab '%s' %s: %s %.1f, threshold %.1f", st->rule.name, s->tab,
+	     st->active ? "activated" : "deactivated", alert_condition_name(st->rule.condition), st->value,
+	     st->rule.threshold);
+
+	if (!s->cb)
+		return;
+
+	struct alert_event event = {
+		.tab = s->tab,
+		.rule = st->rule.name,
+		.condition = st->rule.condition,
+		.active = st->active,
+		.value = st->value,
+		.threshold = st->rule.threshold,
+	};
+	s->cb(s->param, &event);
+}
+
+static bool evaluate(const struct alert_rule *rule, const double results[5], double block_peak, double *value)
+{
+	switch (rule->condition) {
+	case ALERT_SHORT_BELOW:
+		*value = results[1];
+		return results[1] < rule->threshold;
+	case ALERT_SHORT_ABOVE:
+		*value = results[1];
+		return results[1] > rule->threshold;
+	case ALERT_PEAK_OVER:
+		*value = block_peak;
+		return block_peak > rule->threshold;
+	case ALERT_INTEGRATED_DRIFT:
+		*value = results[2];
+		/* Not drifting until the first gating block passes the absolute gate. */
+		return isfinite(results[2]) && fabs(results[2] - rule->threshold) > rule->tolerance;
+	}
+	return false;
+}
+
+void alert_set_update(alert_set_t *s, const double results[5], double block_peak)
+{
+	if (!s->armed)
+		return;
+
+	for (size_t i = 0; i < s->n; i++) {
+		struct alert_state *st = &s->states[i];
+
+		double value = -HUGE_VAL;
+		const bool cond = evaluate(&st->rule, results, block_peak, &value);
+		if (cond == st->active) {
+			st->count = 0;
+			st->value = value;
+			continue;
+		}
+
+		if (++st->count < (st->active ? st->release_blocks : st->attack_blocks))
+			continue;
+
+		st->active = cond;
+		st->count = 0;
+		st->value = value;
+		emit(s, st);
+	}
+}
+
+void alert_set_arm(alert_set_t *s, bool armed)
+{
+	if (s->armed == armed)
+		return;
+
+	s->armed = armed;
+	for (size_t i = 0; i < s->n; i++) {
+		struct alert_state *st = &s->states[i];
+		st->count = 0;
+		if (!armed && st->active) {
+			st->active = false;
+			emit(s, st);
+		}
+	}
+}
+
+const char *alert_condition_name(enum alert_condition condition)
+{
+	switch (condition) {
+	case ALERT_SHORT_BELOW:
+		return "short_below";
+	case ALERT_SHORT_ABOVE:
+		return "short_above";
+	case ALERT_PEAK_OVER:
+		return "peak_over";
+	case ALERT_INTEGRATED_DRIFT:
+		return "integrated_drift";
+	}
+	return "unknown";
+}
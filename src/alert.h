@@ -0,0 +1,69 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Alert rules of a tab, evaluated by the analysis thread for every 100 ms block.
+ *
+ * A rule becomes active when its condition holds for `duration` seconds and becomes inactive when the
+ * condition does not hold for `duration` seconds, or at least `ALERT_RELEASE_BLOCKS` blocks so that a
+ * rule without a duration does not toggle at every block. The callback is called only at the transitions. */
+
+enum alert_condition {
+	ALERT_SHORT_BELOW = 0,
+	ALERT_SHORT_ABOVE = 1,
+	/* The peak of each block in dBTP or dBFS, depending on the peak mode of the tab */
+	ALERT_PEAK_OVER = 2,
+	/* The integrated loudness is farther than `tolerance` from `threshold` */
+	ALERT_INTEGRATED_DRIFT = 3,
+};
+
+#define ALERT_RELEASE_BLOCKS 10
+
+struct alert_rule
+{
+	const char *name;
+	enum alert_condition condition;
+	double threshold;
+	double tolerance;
+	double duration;
+};
+
+struct alert_event
+{
+	const char *tab;
+	const char *rule;
+	enum alert_condition condition;
+	bool active;
+	double value;
+	double threshold;
+};
+
+typedef void (*alert_cb_t)(void *param, const struct alert_event *event);
+
+typedef struct alert_set alert_set_t;
+
+/* The strings are copied. */
+alert_set_t *alert_set_create(const char *tab, const struct alert_rule *rules, size_t n, alert_cb_t cb, void *param);
+void alert_set_destroy(alert_set_t *s);
+
+/* Returns true if the set was created by the same arguments so that the state can be kept. */
+bool alert_set_equals(const alert_set_t *s, const char *tab, const struct alert_rule *rules, size_t n, alert_cb_t cb,
+		      void *param);
+
+/* Called for each block. `results` is same as `loudness_get`, `block_peak` is the peak of the block in dB. */
+void alert_set_update(alert_set_t *s, const double results[5], double block_peak);
+
+/* The rules are evaluated only while armed. Disarming deactivates the active rules. */
+void alert_set_arm(alert_set_t *s, bool armed);
+
+const char *alert_condition_name(enum alert_condition condition);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
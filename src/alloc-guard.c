@@ -0,0 +1,77 @@
+/*
+Loudness Dock for OBS Studio
+Copyright (C) 2025 Norihiro Kamae <norihiro@nagater.net>
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#include <obs-module.h>
+#include <util/threading.h>
+#include "plugin-macros.generated.h"
+#include "alloc-guard.h"
+
+#ifdef WITH_ASSERT_NO_ALLOC
+
+/* Linked with `-Wl,--wrap=bmalloc,--wrap=brealloc` so that the calls from the plugin,
+ * including the inline functions of darray and bzalloc, come here first. */
+void *__real_bmalloc(size_t size);
+void *__real_brealloc(void *ptr, size_t size);
+
+static _Thread_local int guard_depth = 0;
+static volatile long n_allocs = 0;
+
+void alloc_guard_enter(void)
+{
+	guard_depth++;
+}
+
+void alloc_guard_leave(void)
+{
+	guard_depth--;
+}
+
+static void count_alloc(const char *func, size_t size)
+{
+	if (!guard_depth)
+		return;
+
+	/* Log the 1st, 2nd, 4th, 8th, ... occurrence so that a regression does not flood the log. */
+	const long n = os_atomic_inc_long(&n_allocs);
+	if ((n & (n - 1)) == 0)
+		blog(LOG_ERROR, "%s(%zu) called on the audio thread, %ld time(s) so far", func, size, n);
+}
+
+void *__wrap_bmalloc(size_t size)
+{
+	count_alloc("bmalloc", size);
+	return __real_bmalloc(size);
+}
+
+void *__wrap_brealloc(void *ptr, size_t size)
+{
+	count_alloc("brealloc", size);
+	return __real_brealloc(ptr, size);
+}
+
+void alloc_guard_report(void)
+{
+	const long n = os_atomic_load_long(&n_allocs);
+	if (n)
+		blog(LOG_ERROR, "%ld allocation(s) on the audio thread", n);
+	else
+		blog(LOG_INFO, "no allocation on the audio thread");
+}
+
+#endif
@@ -0,0 +1,25 @@
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Debugging aid enabled by `WITH_ASSERT_NO_ALLOC`.
+ *
+ * The audio callbacks mark their thread with `ALLOC_GUARD_ENTER` and `ALLOC_GUARD_LEAVE`.
+ * `bmalloc` and `brealloc` called by the plugin are wrapped at link time and any allocation
+ * inside the marked section is counted and logged. */
+#ifdef WITH_ASSERT_NO_ALLOC
+void alloc_guard_enter(void);
+void alloc_guard_leave(void);
+void alloc_guard_report(void);
+#define ALLOC_GUARD_ENTER() alloc_guard_enter()
+#define ALLOC_GUARD_LEAVE() alloc_guard_leave()
+#else
+#define ALLOC_GUARD_ENTER()
+#define ALLOC_GUARD_LEAVE()
+#endif
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
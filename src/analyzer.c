@@ -0,0 +1,600 @@
+/*
+Loudness Dock for OBS Studio
+Copyright (C) 2025 Norihiro Kamae <norihiro@nagater.net>
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#include <obs-module.h>
+#include <util/threading.h>
+#include <util/darray.h>
+#include "analyzer.h"
+#include "audio-ring.h"
+#include "worker-pool.h"
+#include "loudness.h"
+#include "gating.h"
+#include "history.h"
+#include "plugin-macros.generated.h"
+#include "alloc-guard.h"
+
+typedef DARRAY(struct analyzer_client *) client_array_t;
+typedef DARRAY(analyzer_t *) analyzer_array_t;
+
+struct analyzer
+{
+	/* Either `track` is a mix index, or `track` is -1 and `source_name` names the source. */
+	int track;
+	char *source_name;
+	char desc[64];
+
+	/* Protected by `registry_mutex` */
+	long refs;
+	size_t n_active;
+	obs_weak_source_t *source;
+	bool callback_added;
+
+	/* Locked by the worker while processing the ring.
+	 * Protects `r128`, `clients`, and the states of the clients. */
+	pthread_mutex_t mutex;
+	r128_t *r128;
+	client_array_t clients;
+
+	/* Used only by the worker. */
+	long overruns_reported;
+	struct r128_history blocks;
+
+	/* Momentary and short-term loudness of the whole session, regardless of the resets of the tabs.
+	 * `history_restart` is set when the audio stops and resumes so that a new segment begins. */
+	history_t *history;
+	volatile long history_restart;
+
+	/* The audio thread pushes the frames and a worker of the pool drains. */
+	struct audio_ring ring;
+	struct worker_job job;
+	bool job_added;
+};
+
+/* 24 hours, about 3.5 MB for each track or source */
+#define HISTORY_RETENTION_SECONDS (24 * 60 * 60)
+
+static pthread_mutex_t registry_mutex = PTHREAD_MUTEX_INITIALIZER;
+static analyzer_t *registry[MAX_AUDIO_MIXES];
+static analyzer_array_t source_registry;
+
+static void audio_cb(void *param, size_t mix_idx, struct audio_data *data);
+static void source_audio_cb(void *param, obs_source_t *source, const struct audio_data *data, bool muted);
+static void process_ring(void *data);
+static void analyzer_destroy(analyzer_t *a);
+
+static analyzer_t *analyzer_create(int track, const char *source_name)
+{
+	struct obs_audio_info oai;
+	if (!obs_get_audio_info(&oai)) {
+		blog(LOG_ERROR, "obs_get_audio_info failed");
+		return NULL;
+	}
+
+	analyzer_t *a = bzalloc(sizeof(analyzer_t));
+	a->track = track;
+	a->source_name = bstrdup(source_name);
+	if (source_name)
+		snprintf(a->desc, sizeof(a->desc), "source='%s'", source_name);
+	else
+		snprintf(a->desc, sizeof(a->desc), "track=%d", track);
+	pthread_mutex_init(&a->mutex, NULL);
+
+	a->r128 = r128_create(get_audio_channels(oai.speakers), oai.samples_per_sec);
+	if (!a->r128) {
+		analyzer_destroy(a);
+		return NULL;
+	}
+
+	/* Keep about a half second for a track so that the worker can be descheduled for a while.
+	 * Sources can be many. Their rings are kept short, a few audio ticks. */
+	size_t ring_frames = source_name ? AUDIO_OUTPUT_FRAMES * 8 : r128_samplerate(a->r128) / 2;
+	if (!audio_ring_init(&a->ring, r128_channels(a->r128), ring_frames)) {
+		blog(LOG_ERROR, "Failed to allocate audio ring");
+		analyzer_destroy(a);
+		return NULL;
+	}
+
+	a->history = history_create(HISTORY_RETENTION_SECONDS);
+
+	a->job.run = process_ring;
+	a->job.param = a;
+	if (!worker_pool_add(&a->job)) {
+		analyzer_destroy(a);
+		return NULL;
+	}
+	a->job_added = true;
+
+	return a;
+}
+
+static void analyzer_destroy(analyzer_t *a)
+{
+	if (a->job_added) {
+		worker_pool_remove(&a->job);
+
+		struct loudness_stats stats;
+		analyzer_get_stats(a, &stats);
+		blog(LOG_INFO, "%s ring high-water=%zu/%zu frames, overruns=%zu, dropped=%zu frames", a->desc,
+		     stats.ring_high_water, stats.ring_capacity, stats.ring_overruns, stats.ring_dropped_frames);
+	}
+
+	if (a->clients.num)
+		blog(LOG_ERROR, "%s: analyzer destroyed with %zu client(s)", a->desc, a->clients.num);
+
+	r128_destroy(a->r128);
+	da_free(a->clients);
+	pthread_mutex_destroy(&a->mutex);
+	audio_ring_free(&a->ring);
+	history_destroy(a->history);
+	bfree(a->source_name);
+	bfree(a);
+}
+
+/* Called with `registry_mutex` locked. */
+static void set_callback(analyzer_t *a, bool want)
+{
+	if (want == a->callback_added)
+		return;
+
+	if (a->track >= 0) {
+		if (want)
+			obs_add_raw_audio_callback(a->track, NULL, audio_cb, a);
+		else
+			obs_remove_raw_audio_callback(a->track, audio_cb, a);
+	}
+	else {
+		/* If the source is already gone, its callbacks are gone too. */
+		obs_source_t *source = obs_weak_source_get_source(a->source);
+		if (source) {
+			if (want)
+				obs_source_add_audio_capture_callback(source, source_audio_cb, a);
+			else
+				obs_source_remove_audio_capture_callback(source, source_audio_cb, a);
+			obs_source_release(source);
+		}
+		else if (want) {
+			return;
+		}
+	}
+
+	a->callback_added = want;
+	if (want)
+		os_atomic_set_long(&a->history_restart, 1);
+}
+
+/* Registers the audio callback while any client is active and, for a source, the source exists.
+ * Called with `registry_mutex` locked. */
+static void update_callback(analyzer_t *a)
+{
+	set_callback(a, a->n_active > 0 && (a->track >= 0 || a->source));
+}
+
+/* Called with `registry_mutex` locked. */
+static void attach_source(analyzer_t *a, obs_source_t *source)
+{
+	if (a->source)
+		return;
+
+	a->source = obs_source_get_weak_source(source);
+	update_callback(a);
+}
+
+/* Called with `registry_mutex` locked. */
+static void detach_source(analyzer_t *a)
+{
+	if (!a->source)
+		return;
+
+	set_callback(a, false);
+
+	obs_weak_source_release(a->source);
+	a->source = NULL;
+}
+
+analyzer_t *analyzer_get(int track)
+{
+	if (track < 0 || track >= MAX_AUDIO_MIXES) {
+		blog(LOG_ERROR, "analyzer_get: invalid track %d", track);
+		return NULL;
+	}
+
+	pthread_mutex_lock(&registry_mutex);
+
+	analyzer_t *a = registry[track];
+	if (a) {
+		a->refs++;
+	}
+	else if ((a = analyzer_create(track, NULL))) {
+		a->refs = 1;
+		registry[track] = a;
+	}
+
+	pthread_mutex_unlock(&registry_mutex);
+
+	return a;
+}
+
+analyzer_t *analyzer_get_source(const char *name)
+{
+	if (!name || !*name) {
+		blog(LOG_ERROR, "analyzer_get_source: empty source name");
+		return NULL;
+	}
+
+	pthread_mutex_lock(&registry_mutex);
+
+	analyzer_t *a = NULL;
+	for (size_t i = 0; i < source_registry.num; i++) {
+		if (strcmp(source_registry.array[i]->source_name, name) == 0) {
+			a = source_registry.array[i];
+			break;
+		}
+	}
+
+	if (a) {
+		a->refs++;
+	}
+	else if ((a = analyzer_create(-1, name))) {
+		a->refs = 1;
+		da_push_back(source_registry, &a);
+
+		/* The source might not exist yet, such as while the scene collection is being loaded.
+		 * Then it will be attached by the `source_create` signal. */
+		obs_source_t *source = obs_get_source_by_name(name);
+		if (source) {
+			attach_source(a, source);
+			obs_source_release(source);
+		}
+	}
+
+	pthread_mutex_unlock(&registry_mutex);
+
+	return a;
+}
+
+void analyzer_release(analyzer_t *a)
+{
+	if (!a)
+		return;
+
+	pthread_mutex_lock(&registry_mutex);
+	const bool last = --a->refs == 0;
+	if (last) {
+		if (a->track >= 0) {
+			registry[a->track] = NULL;
+		}
+		else {
+			detach_source(a);
+			da_erase_item(source_registry, &a);
+			if (!source_registry.num)
+				da_free(source_registry);
+		}
+	}
+	pthread_mutex_unlock(&registry_mutex);
+
+	if (last)
+		analyzer_destroy(a);
+}
+
+int analyzer_track(const analyzer_t *a)
+{
+	return a->track;
+}
+
+const char *analyzer_source_name(const analyzer_t *a)
+{
+	return a->source_name;
+}
+
+uint32_t analyzer_samplerate(const analyzer_t *a)
+{
+	return r128_samplerate(a->r128);
+}
+
+/* Enables only the peak measurements that the active clients need. */
+static void update_peaks(analyzer_t *a)
+{
+	uint32_t peaks = 0;
+	for (size_t i = 0; i < a->clients.num; i++) {
+		if (a->clients.array[i]->active)
+			peaks |= a->clients.array[i]->peaks;
+	}
+	r128_set_peaks(a->r128, peaks);
+}
+
+static void set_active_locked(analyzer_t *a, struct analyzer_client *c, bool active)
+{
+	if (c->active == active)
+		return;
+
+	c->active = active;
+	if (active)
+		a->n_active++;
+	else
+		a->n_active--;
+	update_peaks(a);
+}
+
+void analyzer_add_client(analyzer_t *a, struct analyzer_client *c)
+{
+	pthread_mutex_lock(&registry_mutex);
+
+	pthread_mutex_lock(&a->mutex);
+	c->active = false;
+	da_push_back(a->clients, &c);
+	set_active_locked(a, c, true);
+	pthread_mutex_unlock(&a->mutex);
+
+	update_callback(a);
+
+	pthread_mutex_unlock(&registry_mutex);
+}
+
+void analyzer_remove_client(analyzer_t *a, struct analyzer_client *c)
+{
+	pthread_mutex_lock(&registry_mutex);
+
+	pthread_mutex_lock(&a->mutex);
+	set_active_locked(a, c, false);
+	da_erase_item(a->clients, &c);
+	pthread_mutex_unlock(&a->mutex);
+
+	update_callback(a);
+
+	pthread_mutex_unlock(&registry_mutex);
+}
+
+void analyzer_set_client_active(analyzer_t *a, struct analyzer_client *c, bool active)
+{
+	pthread_mutex_lock(&registry_mutex);
+
+	pthread_mutex_lock(&a->mutex);
+	set_active_locked(a, c, active);
+	pthread_mutex_unlock(&a->mutex);
+
+	update_callback(a);
+
+	pthread_mutex_unlock(&registry_mutex);
+}
+
+static void on_source_create(void *data, calldata_t *cd)
+{
+	UNUSED_PARAMETER(data);
+	obs_source_t *source = calldata_ptr(cd, "source");
+	const char *name = obs_source_get_name(source);
+	if (!name)
+		return;
+
+	pthread_mutex_lock(&registry_mutex);
+	for (size_t i = 0; i < source_registry.num; i++) {
+		analyzer_t *a = source_registry.array[i];
+		if (strcmp(a->source_name, name) == 0)
+			attach_source(a, source);
+	}
+	pthread_mutex_unlock(&registry_mutex);
+}
+
+static void on_source_destroy(void *data, calldata_t *cd)
+{
+	UNUSED_PARAMETER(data);
+	obs_source_t *source = calldata_ptr(cd, "source");
+
+	pthread_mutex_lock(&registry_mutex);
+	for (size_t i = 0; i < source_registry.num; i++) {
+		analyzer_t *a = source_registry.array[i];
+		if (a->source && obs_weak_source_references_source(a->source, source))
+			detach_source(a);
+	}
+	pthread_mutex_unlock(&registry_mutex);
+}
+
+/* The tab follows the name. A renamed source is detached and a source renamed to the name is attached. */
+static void on_source_rename(void *data, calldata_t *cd)
+{
+	UNUSED_PARAMETER(data);
+	obs_source_t *source = calldata_ptr(cd, "source");
+	const char *new_name = calldata_string(cd, "new_name");
+
+	pthread_mutex_lock(&registry_mutex);
+	for (size_t i = 0; i < source_registry.num; i++) {
+		analyzer_t *a = source_registry.array[i];
+		if (a->source && obs_weak_source_references_source(a->source, source))
+			detach_source(a);
+		if (new_name && strcmp(a->source_name, new_name) == 0)
+			attach_source(a, source);
+	}
+	pthread_mutex_unlock(&registry_mutex);
+}
+
+/* Connected for the lifetime of the module. The handlers are called with the mutex of the signal locked and
+ * lock `registry_mutex`, so connecting them while holding `registry_mutex` would take the locks in the reverse
+ * order. */
+void analyzer_module_load(void)
+{
+	signal_handler_t *sh = obs_get_signal_handler();
+	signal_handler_connect(sh, "source_create", on_source_create, NULL);
+	signal_handler_connect(sh, "source_destroy", on_source_destroy, NULL);
+	signal_handler_connect(sh, "source_rename", on_source_rename, NULL);
+}
+
+void analyzer_module_unload(void)
+{
+	signal_handler_t *sh = obs_get_signal_handler();
+	signal_handler_disconnect(sh, "source_create", on_source_create, NULL);
+	signal_handler_disconnect(sh, "source_destroy", on_source_destroy, NULL);
+	signal_handler_disconnect(sh, "source_rename", on_source_rename, NULL);
+}
+
+void analyzer_lock(analyzer_t *a)
+{
+	pthread_mutex_lock(&a->mutex);
+}
+
+bool analyzer_trylock(analyzer_t *a)
+{
+	return pthread_mutex_trylock(&a->mutex) == 0;
+}
+
+void analyzer_unlock(analyzer_t *a)
+{
+	pthread_mutex_unlock(&a->mutex);
+}
+
+#ifdef ENABLE_PROFILE
+static const char *name_audio_cb = "loudness-audio_cb";
+#endif
+
+static void audio_cb(void *param, size_t mix_idx, struct audio_data *data)
+{
+#ifdef ENABLE_PROFILE
+	profile_start(name_audio_cb);
+#endif
+
+	UNUSED_PARAMETER(mix_idx);
+	analyzer_t *a = param;
+
+	/* Never lock nor allocate here. Just hand the frames to the analysis thread. */
+	ALLOC_GUARD_ENTER();
+	if (audio_ring_push(&a->ring, (const float *const *)data->data, data->frames))
+		worker_job_schedule(&a->job);
+	ALLOC_GUARD_LEAVE();
+
+#ifdef ENABLE_PROFILE
+	profile_end(name_audio_cb);
+#endif
+}
+
+static void source_audio_cb(void *param, obs_source_t *source, const struct audio_data *data, bool muted)
+{
+#ifdef ENABLE_PROFILE
+	profile_start(name_audio_cb);
+#endif
+
+	UNUSED_PARAMETER(source);
+	analyzer_t *a = param;
+
+	/* Muted sources are measured as silence. NULL planes are written as zeros. */
+	static const float *const silence[MAX_AV_PLANES] = {NULL};
+	const float *const *planes = muted ? silence : (const float *const *)data->data;
+
+	ALLOC_GUARD_ENTER();
+	if (audio_ring_push(&a->ring, planes, data->frames))
+		worker_job_schedule(&a->job);
+	ALLOC_GUARD_LEAVE();
+
+#ifdef ENABLE_PROFILE
+	profile_end(name_audio_cb);
+#endif
+}
+
+#ifdef ENABLE_PROFILE
+static const char *name_process = "loudness-process";
+#endif
+
+/* Called by the worker with the analyzer locked. */
+static void record_history(analyzer_t *a, const struct r128_block *block, bool restart)
+{
+	r128_history_add(&a->blocks, block->energy);
+
+	const double momentary = gating_lufs_from_energy(r128_history_energy(&a->blocks, R128_MOMENTARY_BLOCKS));
+	const double short_term = gating_lufs_from_energy(r128_history_energy(&a->blocks, R128_SHORT_TERM_BLOCKS));
+
+	/* The block ended before the frames still waiting in the ring. */
+	const uint64_t backlog_ms = (uint64_t)audio_ring_available(&a->ring) * 1000 / r128_samplerate(a->r128);
+	history_add(a->history, os_gettime_ns() / 1000000 - backlog_ms, momentary, short_term, restart);
+}
+
+static void process_ring(void *data)
+{
+	analyzer_t *a = data;
+
+#ifdef ENABLE_PROFILE
+	profile_start(name_process);
+#endif
+
+	/* Dropped frames also break the continuity of the history. */
+	const long overruns = os_atomic_load_long(&a->ring.overruns);
+	bool restart = os_atomic_exchange_long(&a->history_restart, 0) || overruns != a->overruns_reported;
+
+	const uint32_t nch = r128_channels(a->r128);
+	size_t offset;
+	size_t frames;
+	while ((frames = audio_ring_peek(&a->ring, &offset)) > 0) {
+		/* Locked for each block so that other threads waiting for the lock are not held
+		 * while the whole ring is drained. */
+		pthread_mutex_lock(&a->mutex);
+
+		/* Feed the planes in the ring directly. No interleaving, no copy. */
+		const float *planes[R128_MAX_CHANNELS];
+		for (uint32_t ch = 0; ch < nch; ch++)
+			planes[ch] = audio_ring_plane(&a->ring, ch) + offset;
+
+		/* Stops at the 100 ms boundary so that the results are published as soon as a block completes. */
+		bool block_completed = false;
+		struct r128_block block;
+		frames = r128_add_planar(a->r128, planes, frames, &block, &block_completed);
+
+		audio_ring_consume(&a->ring, frames);
+
+		if (block_completed) {
+			record_history(a, &block, restart);
+			restart = false;
+
+			for (size_t i = 0; i < a->clients.num; i++) {
+				struct analyzer_client *c = a->clients.array[i];
+				if (c->active)
+					c->block_cb(c->param, &block);
+			}
+		}
+
+		pthread_mutex_unlock(&a->mutex);
+	}
+
+	/* Keep it for the next block if no block completed this time. */
+	if (restart)
+		os_atomic_set_long(&a->history_restart, 1);
+
+	if (overruns != a->overruns_reported) {
+		struct loudness_stats stats;
+		analyzer_get_stats(a, &stats);
+		blog(LOG_WARNING,
+		     "%s: analysis thread could not keep up, overruns=%zu, dropped=%zu frames, high-water=%zu/%zu frames",
+		     a->desc, stats.ring_overruns, stats.ring_dropped_frames, stats.ring_high_water,
+		     stats.ring_capacity);
+		a->overruns_reported = overruns;
+	}
+
+#ifdef ENABLE_PROFILE
+	profile_end(name_process);
+#endif
+}
+
+void analyzer_query_history(analyzer_t *a, uint64_t since_ms, uint64_t until_ms, uint32_t decimate,
+			    struct history_result *result)
+{
+	history_query(a->history, since_ms, until_ms, decimate, result);
+}
+
+void analyzer_get_stats(const analyzer_t *a, struct loudness_stats *stats)
+{
+	stats->ring_capacity = a->ring.capacity;
+	stats->ring_high_water = (size_t)os_atomic_load_long(&a->ring.high_water);
+	stats->ring_overruns = (size_t)os_atomic_load_long(&a->ring.overruns);
+	stats->ring_dropped_frames = (size_t)os_atomic_load_long(&a->ring.dropped_frames);
+}
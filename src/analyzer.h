@@ -0,0 +1,75 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "r128.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Shared front-end of a mix track or a source.
+ *
+ * The audio callback, the ring buffer, the K-weighting filter and the peak detection
+ * run once per track or source regardless of the number of tabs watching it.
+ * Every 100 ms, the block is handed to the clients, each of them accumulating its own
+ * loudness with its own gating, pause, and reset. */
+typedef struct analyzer analyzer_t;
+
+struct analyzer_client
+{
+	/* Called by the analysis thread with the analyzer locked. */
+	void (*block_cb)(void *param, const struct r128_block *block);
+	void *param;
+
+	/* Bitmask of `R128_PEAK_BIT` that the client needs */
+	uint32_t peaks;
+
+	/* Managed by the analyzer. */
+	bool active;
+};
+
+/* Connects the signals that attach the analyzers of the sources to the sources created or renamed later.
+ * Called at the load and the unload of the module. */
+void analyzer_module_load(void);
+void analyzer_module_unload(void);
+
+/* Returns the analyzer of the track, creating it if this is the first user.
+ * Each call has to be paired with `analyzer_release`. */
+analyzer_t *analyzer_get(int track);
+
+/* Same as `analyzer_get` but for the source of the name.
+ * The source is looked up by name, also when a source is created or renamed later. */
+analyzer_t *analyzer_get_source(const char *name);
+
+void analyzer_release(analyzer_t *a);
+
+/* Returns -1 for a source. */
+int analyzer_track(const analyzer_t *a);
+/* Returns NULL for a track. */
+const char *analyzer_source_name(const analyzer_t *a);
+uint32_t analyzer_samplerate(const analyzer_t *a);
+
+/* The client is added as active. The client has to be kept valid until it is removed. */
+void analyzer_add_client(analyzer_t *a, struct analyzer_client *c);
+void analyzer_remove_client(analyzer_t *a, struct analyzer_client *c);
+
+/* The audio callback is registered only while at least one client is active. */
+void analyzer_set_client_active(analyzer_t *a, struct analyzer_client *c, bool active);
+
+/* Serializes the access to the states of the clients with the analysis thread. */
+void analyzer_lock(analyzer_t *a);
+bool analyzer_trylock(analyzer_t *a);
+void analyzer_unlock(analyzer_t *a);
+
+/* See `history_query`. */
+struct history_result;
+void analyzer_query_history(analyzer_t *a, uint64_t since_ms, uint64_t until_ms, uint32_t decimate,
+			    struct history_result *result);
+
+struct loudness_stats;
+void analyzer_get_stats(const analyzer_t *a, struct loudness_stats *stats);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
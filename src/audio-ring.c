@@ -0,0 +1,105 @@
+/*
+Loudness Dock for OBS Studio
+Copyright (C) 2025 Norihiro Kamae <norihiro@nagater.net>
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#include <obs-module.h>
+#include <util/threading.h>
+#include "audio-ring.h"
+
+bool audio_ring_init(struct audio_ring *ring, size_t channels, size_t min_frames)
+{
+	size_t capacity = 1;
+	while (capacity < min_frames)
+		capacity <<= 1;
+
+	memset(ring, 0, sizeof(*ring));
+	ring->data = bzalloc(sizeof(float) * channels * capacity);
+	if (!ring->data)
+		return false;
+
+	ring->channels = channels;
+	ring->capacity = capacity;
+	return true;
+}
+
+void audio_ring_free(struct audio_ring *ring)
+{
+	bfree(ring->data);
+	ring->data = NULL;
+}
+
+static inline size_t ring_used(long write_pos, long read_pos)
+{
+	return (size_t)((unsigned long)write_pos - (unsigned long)read_pos);
+}
+
+bool audio_ring_push(struct audio_ring *ring, const float *const *planes, size_t frames)
+{
+	const long write_pos = ring->write_pos; /* Only the producer writes it. */
+	const long read_pos = os_atomic_load_long(&ring->read_pos);
+	const size_t used = ring_used(write_pos, read_pos);
+
+	if (used + frames > ring->capacity) {
+		os_atomic_inc_long(&ring->overruns);
+		os_atomic_set_long(&ring->dropped_frames, ring->dropped_frames + (long)frames);
+		return false;
+	}
+
+	const size_t mask = ring->capacity - 1;
+	const size_t start = (unsigned long)write_pos & mask;
+	const size_t n1 = frames < ring->capacity - start ? frames : ring->capacity - start;
+	const size_t n2 = frames - n1;
+
+	for (size_t ch = 0; ch < ring->channels; ch++) {
+		float *dst = ring->data + ch * ring->capacity;
+		const float *src = planes[ch];
+		if (!src) {
+			memset(dst + start, 0, sizeof(float) * n1);
+			memset(dst, 0, sizeof(float) * n2);
+			continue;
+		}
+		memcpy(dst + start, src, sizeof(float) * n1);
+		memcpy(dst, src + n1, sizeof(float) * n2);
+	}
+
+	os_atomic_set_long(&ring->write_pos, (long)((unsigned long)write_pos + frames));
+
+	if ((long)(used + frames) > ring->high_water)
+		os_atomic_set_long(&ring->high_water, (long)(used + frames));
+
+	return true;
+}
+
+size_t audio_ring_available(const struct audio_ring *ring)
+{
+	return ring_used(os_atomic_load_long(&ring->write_pos), ring->read_pos);
+}
+
+size_t audio_ring_peek(const struct audio_ring *ring, size_t *offset)
+{
+	const size_t avail = audio_ring_available(ring);
+	const size_t start = (unsigned long)ring->read_pos & (ring->capacity - 1);
+
+	*offset = start;
+	return avail < ring->capacity - start ? avail : ring->capacity - start;
+}
+
+void audio_ring_consume(struct audio_ring *ring, size_t frames)
+{
+	os_atomic_set_long(&ring->read_pos, (long)((unsigned long)ring->read_pos + frames));
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Lock-free single-producer single-consumer ring of planar float frames.
+ *
+ * The producer is the audio thread of OBS; it must not allocate nor lock.
+ * The consumer is the analysis thread. All storage is allocated in
+ * `audio_ring_init`. */
+struct audio_ring
+{
+	float *data;
+	size_t channels;
+	size_t capacity; /* frames per channel, power of two */
+
+	/* Free-running frame counters. Only their difference is meaningful. */
+	volatile long write_pos;
+	volatile long read_pos;
+
+	/* Statistics, written by the producer. */
+	volatile long high_water;
+	volatile long overruns;
+	volatile long dropped_frames;
+};
+
+bool audio_ring_init(struct audio_ring *ring, size_t channels, size_t min_frames);
+void audio_ring_free(struct audio_ring *ring);
+
+/* Producer side. Writes all frames or nothing.
+ * Returns false and counts an overrun if the ring does not have enough space. */
+bool audio_ring_push(struct audio_ring *ring, const float *const *planes, size_t frames);
+
+/* Consumer side. */
+size_t audio_ring_available(const struct audio_ring *ring);
+
+/* Returns the number of contiguous frames that can be read without wrapping around,
+ * and sets `offset` to the position of the first frame in each plane. */
+size_t audio_ring_peek(const struct audio_ring *ring, size_t *offset);
+
+static inline const float *audio_ring_plane(const struct audio_ring *ring, size_t ch)
+{
+	return ring->data + ch * ring->capacity;
+}
+
+void audio_ring_consume(struct audio_ring *ring, size_t frames);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
@@ -10,6 +10,7 @@
 #include <QScrollBar>
 #include <QCheckBox>
 #include <QComboBox>
+#include <QSpinBox>
 #include "plugin-macros.generated.h"
 #include "config-dialog.hpp"
 #include "config-dialog-table-delegate.hpp"
@@ -41,14 +42,56 @@ ConfigDialog::ConfigDialog(const loudness_dock_config_s &cfg, QWidget *parent)
 	connect(abbrevLabelCheck, &QCheckBox::toggled, this, &ConfigDialog::on_abbrev_label_changed);
 	topLayout->addWidget(abbrevLabelCheck, row++, 1);
 
+	overviewCheck = new QCheckBox(obs_module_text("Config.Overview"), this);
+	overviewCheck->setCheckState(cfg.overview ? Qt::Checked : Qt::Unchecked);
+	overviewCheck->setToolTip(obs_module_text("Config.Overview.Tooltip"));
+	connect(overviewCheck, &QCheckBox::toggled, this, &ConfigDialog::on_overview_changed);
+	topLayout->addWidget(overviewCheck, row++, 1);
+
+	sessionLogCheck = new QCheckBox(obs_module_text("Config.SessionLog"), this);
+	sessionLogCheck->setCheckState(cfg.session_log ? Qt::Checked : Qt::Unchecked);
+	sessionLogCheck->setToolTip(obs_module_text("Config.SessionLog.Tooltip"));
+	connect(sessionLogCheck, &QCheckBox::toggled, this, &ConfigDialog::on_session_log_changed);
+	topLayout->addWidget(sessionLogCheck, row++, 1);
+
+	topLayout->addWidget(new QLabel(obs_module_text("Config.EventInterval"), this), row, 0);
+	eventIntervalSpin = new QSpinBox(this);
+	eventIntervalSpin->setRange(0, 10000);
+	eventIntervalSpin->setSingleStep(50);
+	eventIntervalSpin->setSuffix(" ms");
+	eventIntervalSpin->setSpecialValueText(obs_module_text("Config.EventInterval.Off"));
+	eventIntervalSpin->setToolTip(obs_module_text("Config.EventInterval.Tooltip"));
+	eventIntervalSpin->setValue(cfg.event_interval_ms);
+	connect(eventIntervalSpin, &QSpinBox::valueChanged, this, &ConfigDialog::on_event_interval_changed);
+	topLayout->addWidget(eventIntervalSpin, row++, 1);
+
+	topLayout->addWidget(new QLabel(obs_module_text("Config.IdleRefresh"), this), row, 0);
+	idleRefreshSpin = new QSpinBox(this);
+	idleRefreshSpin->setRange(100, 1000);
+	idleRefreshSpin->setSingleStep(100);
+	idleRefreshSpin->setSuffix(" ms");
+	idleRefreshSpin->setToolTip(obs_module_text("Config.IdleRefresh.Tooltip"));
+	idleRefreshSpin->setValue(cfg.idle_refresh_ms);
+	connect(idleRefreshSpin, &QSpinBox::valueChanged, this, &ConfigDialog::on_idle_refresh_changed);
+	topLayout->addWidget(idleRefreshSpin, row++, 1);
+
+	topLayout->addWidget(new QLabel(obs_module_text("Config.GraphMinutes"), this), row, 0);
+	graphMinutesSpin = new QSpinBox(this);
+	graphMinutesSpin->setRange(0, 180);
+	graphMinutesSpin->setSpecialValueText(obs_module_text("Config.GraphMinutes.Off"));
+	graphMinutesSpin->setValue(cfg.graph_minutes);
+	connect(graphMinutesSpin, &QSpinBox::valueChanged, this, &ConfigDialog::on_graph_minutes_changed);
+	topLayout->addWidget(graphMinutesSpin, row++, 1);
+
 	// Tabs table
 	topLayout->addWidget(new QLabel(obs_module_text("Config.Tabs"), this), row, 0);
-	tabTable = new QTableWidget(0, 3, this);
+	tabTable = new QTableWidget(0, 6, this);
 	tabTable->setObjectName("tabTable");
 	topLayout->addWidget(tabTable, row++, 1);
 	QStringList tabTableHeader;
 	tabTableHeader << obs_module_text("Config.Tabs.Name") << obs_module_text("Config.Tabs.Track")
-		       << obs_module_text("Config.Trigger");
+		       << obs_module_text("Config.Tabs.Source") << obs_module_text("Config.Trigger")
+		       << obs_module_text("Config.Gating") << obs_module_text("Config.Peak");
 	tabTable->setHorizontalHeaderLabels(tabTableHeader);
 	tabTable->setMinimumWidth(tabTable->horizontalHeader()->length() + tabTable->verticalHeader()->width() +
 				  tabTable->verticalScrollBar()->width());
@@ -70,6 +113,34 @@ ConfigDialog::ConfigDialog(const loudness_dock_config_s &cfg, QWidget *parent)
 	connect(tabTableAdd, &QPushButton::clicked, this, &ConfigDialog::on_tab_table_add);
 	connect(tabTableDel, &QPushButton::clicked, this, &ConfigDialog::on_tab_table_remove);
 
+	// Alert table
+	topLayout->addWidget(new QLabel(obs_module_text("Config.Alerts"), this), row, 0);
+	alertTable = new QTableWidget(0, 6, this);
+	alertTable->setObjectName("alertTable");
+	topLayout->addWidget(alertTable, row++, 1);
+	QStringList alertTableHeader;
+	alertTableHeader << obs_module_text("Config.Alerts.Name") << obs_module_text("Config.Alerts.Tab")
+			 << obs_module_text("Config.Alerts.Condition") << obs_module_text("Config.Alerts.Threshold")
+			 << obs_module_text("Config.Alerts.Tolerance") << obs_module_text("Config.Alerts.Duration");
+	alertTable->setHorizontalHeaderLabels(alertTableHeader);
+
+	auto *alertTableControlLayout = new QHBoxLayout();
+	auto *alertTableAdd = new QPushButton(obs_module_text("Config.Add"), this);
+	auto *alertTableDel = new QPushButton(obs_module_text("Config.Remove"), this);
+	alertTableAdd->setObjectName("alertTableAdd");
+	alertTableDel->setObjectName("alertTableDel");
+	alertTableControlLayout->addWidget(alertTableAdd);
+	alertTableControlLayout->addWidget(alertTableDel);
+	topLayout->addLayout(alertTableControlLayout, row++, 1);
+
+	for (uint32_t i = 0; i < cfg.alerts.size(); i++) {
+		AlertTableAdd(i, cfg.alerts[i]);
+	}
+
+	connect(alertTable, &QTableWidget::cellChanged, this, &ConfigDialog::on_alert_table_changed);
+	connect(alertTableAdd, &QPushButton::clicked, this, &ConfigDialog::on_alert_table_add);
+	connect(alertTableDel, &QPushButton::clicked, this, &ConfigDialog::on_alert_table_remove);
+
 	// Color table
 	topLayout->addWidget(new QLabel(obs_module_text("Config.Colors"), this), row, 0);
 	colorTable = new QTableWidget(0, 3, this);
@@ -148,20 +219,91 @@ void ConfigDialog::TabTableAdd(int ix, const struct loudness_dock_config_s::tab_
 	item = new QTableWidgetItem(QString::number(tab.track));
 	tabTable->setItem(ix, 1, item);
 
+	item = new QTableWidgetItem(QString::fromStdString(tab.source));
+	item->setToolTip(obs_module_text("Config.Tabs.Source.Tooltip"));
+	tabTable->setItem(ix, 2, item);
+
 	auto *trigger = new QComboBox(tabTable);
 	trigger->addItem(obs_module_text("Config.Trigger.None"), loudness_dock_config_s::trigger_none);
 	trigger->addItem(obs_module_text("Config.Trigger.Streaming"), loudness_dock_config_s::trigger_streaming);
 	trigger->addItem(obs_module_text("Config.Trigger.Recording"), loudness_dock_config_s::trigger_recording);
 	trigger->addItem(obs_module_text("Config.Trigger.Both"), loudness_dock_config_s::trigger_both);
 	trigger->setCurrentIndex(tab.trigger_mode); /* Assumes the code starts from 0 and no continuous */
-	tabTable->setCellWidget(ix, 2, trigger);
+	tabTable->setCellWidget(ix, 3, trigger);
 
 	connect(trigger, &QComboBox::currentIndexChanged, [this, trigger](int) {
-		int ix = index_by_widget(tabTable, trigger, 2);
+		int ix = index_by_widget(tabTable, trigger, 3);
 		if (ix >= 0 && ix < (int)config.tabs.size())
 			config.tabs[ix].trigger_mode =
 				(loudness_dock_config_s::trigger_mode_e)trigger->currentData().toInt();
 	});
+
+	auto *gating = new QComboBox(tabTable);
+	gating->addItem(obs_module_text("Config.Gating.Exact"), loudness_dock_config_s::gating_exact);
+	gating->addItem(obs_module_text("Config.Gating.Histogram"), loudness_dock_config_s::gating_histogram);
+	gating->setCurrentIndex(tab.gating_mode);
+	tabTable->setCellWidget(ix, 4, gating);
+
+	connect(gating, &QComboBox::currentIndexChanged, [this, gating](int) {
+		int ix = index_by_widget(tabTable, gating, 4);
+		if (ix >= 0 && ix < (int)config.tabs.size())
+			config.tabs[ix].gating_mode =
+				(loudness_dock_config_s::gating_mode_e)gating->currentData().toInt();
+	});
+
+	auto *peak = new QComboBox(tabTable);
+	peak->addItem(obs_module_text("Config.Peak.True4x"), loudness_dock_config_s::peak_true_4x);
+	peak->addItem(obs_module_text("Config.Peak.True2x"), loudness_dock_config_s::peak_true_2x);
+	peak->addItem(obs_module_text("Config.Peak.Sample"), loudness_dock_config_s::peak_sample);
+	peak->addItem(obs_module_text("Config.Peak.Off"), loudness_dock_config_s::peak_off);
+	peak->setCurrentIndex(tab.peak_mode);
+	tabTable->setCellWidget(ix, 5, peak);
+
+	connect(peak, &QComboBox::currentIndexChanged, [this, peak](int) {
+		int ix = index_by_widget(tabTable, peak, 5);
+		if (ix >= 0 && ix < (int)config.tabs.size())
+			config.tabs[ix].peak_mode = (loudness_dock_config_s::peak_mode_e)peak->currentData().toInt();
+	});
+}
+
+void ConfigDialog::AlertTableAdd(int ix, const struct loudness_dock_config_s::alert_config &alert)
+{
+	ASSERT_THREAD(OBS_TASK_UI);
+
+	alertTable->insertRow(ix);
+
+	auto *item = new QTableWidgetItem(QString::fromStdString(alert.name));
+	alertTable->setItem(ix, 0, item);
+
+	item = new QTableWidgetItem(QString::fromStdString(alert.tab));
+	item->setToolTip(obs_module_text("Config.Alerts.Tab.Tooltip"));
+	alertTable->setItem(ix, 1, item);
+
+	auto *condition = new QComboBox(alertTable);
+	condition->addItem(obs_module_text("Config.Alerts.ShortBelow"), loudness_dock_config_s::alert_short_below);
+	condition->addItem(obs_module_text("Config.Alerts.ShortAbove"), loudness_dock_config_s::alert_short_above);
+	condition->addItem(obs_module_text("Config.Alerts.PeakOver"), loudness_dock_config_s::alert_peak_over);
+	condition->addItem(obs_module_text("Config.Alerts.IntegratedDrift"),
+			   loudness_dock_config_s::alert_integrated_drift);
+	condition->setCurrentIndex(alert.condition);
+	alertTable->setCellWidget(ix, 2, condition);
+
+	connect(condition, &QComboBox::currentIndexChanged, [this, condition](int) {
+		int ix = index_by_widget(alertTable, condition, 2);
+		if (ix >= 0 && ix < (int)config.alerts.size())
+			config.alerts[ix].condition =
+				(loudness_dock_config_s::alert_condition_e)condition->currentData().toInt();
+	});
+
+	item = new QTableWidgetItem(QString::number(alert.threshold, 'f', 1));
+	alertTable->setItem(ix, 3, item);
+
+	item = new QTableWidgetItem(QString::number(alert.tolerance, 'f', 1));
+	item->setToolTip(obs_module_text("Config.Alerts.Tolerance.Tooltip"));
+	alertTable->setItem(ix, 4, item);
+
+	item = new QTableWidgetItem(QString::number(alert.duration, 'f', 1));
+	alertTable->setItem(ix, 5, item);
 }
 
 void ConfigDialog::ColorTableAdd(int ix, float threshold, uint32_t color_fg, uint32_t color_bg)
@@ -248,6 +390,47 @@ void ConfigDialog::on_tab_table_remove()
 	changed();
 }
 
+void ConfigDialog::on_alert_table_add()
+{
+	ASSERT_THREAD(OBS_TASK_UI);
+
+	auto *ci = alertTable->currentItem();
+	int ix = ci && ci->isSelected() ? ci->row() : alertTable->rowCount();
+	if (ix < 0 || (int)config.alerts.size() < ix) {
+		blog(LOG_ERROR, "%s: invalid ix=%d", __func__, ix);
+		return;
+	}
+
+	loudness_dock_config_s::alert_config alert;
+	alert.name = obs_module_text("Config.Alerts.ShortBelow");
+	config.alerts.insert(config.alerts.begin() + ix, alert);
+	alertTable->blockSignals(true);
+	AlertTableAdd(ix, alert);
+	alertTable->blockSignals(false);
+
+	changed();
+}
+
+void ConfigDialog::on_alert_table_remove()
+{
+	ASSERT_THREAD(OBS_TASK_UI);
+
+	auto *ci = alertTable->currentItem();
+	if (!ci || !ci->isSelected())
+		return;
+
+	int ix = ci->row();
+	if (ix < 0 || (int)config.alerts.size() <= ix)
+		return;
+
+	alertTable->blockSignals(true);
+	alertTable->removeRow(ix);
+	config.alerts.erase(config.alerts.begin() + ix);
+	alertTable->blockSignals(false);
+
+	changed();
+}
+
 void ConfigDialog::on_color_table_add()
 {
 	ASSERT_THREAD(OBS_TASK_UI);
@@ -279,6 +462,51 @@ void ConfigDialog::on_abbrev_label_changed(bool checked)
 	changed();
 }
 
+void ConfigDialog::on_overview_changed(bool checked)
+{
+	if (config.overview == checked)
+		return;
+
+	config.overview = checked;
+	changed();
+}
+
+void ConfigDialog::on_session_log_changed(bool checked)
+{
+	if (config.session_log == checked)
+		return;
+
+	config.session_log = checked;
+	changed();
+}
+
+void ConfigDialog::on_event_interval_changed(int interval_ms)
+{
+	if (config.event_interval_ms == interval_ms)
+		return;
+
+	config.event_interval_ms = interval_ms;
+	changed();
+}
+
+void ConfigDialog::on_idle_refresh_changed(int interval_ms)
+{
+	if (config.idle_refresh_ms == interval_ms)
+		return;
+
+	config.idle_refresh_ms = interval_ms;
+	changed();
+}
+
+void ConfigDialog::on_graph_minutes_changed(int minutes)
+{
+	if (config.graph_minutes == minutes)
+		return;
+
+	config.graph_minutes = minutes;
+	changed();
+}
+
 void ConfigDialog::on_tab_table_changed(int row, int column)
 {
 	ASSERT_THREAD(OBS_TASK_UI);
@@ -305,6 +533,56 @@ void ConfigDialog::on_tab_table_changed(int row, int column)
 			item->setText(QString::number(config.tabs[row].track));
 	}
 
+	if (column == 2) {
+		auto *item = tabTable->item(row, 2);
+		if (!item)
+			return;
+		config.tabs[row].source = item->text().trimmed().toUtf8().constData();
+	}
+
+	changed();
+}
+
+void ConfigDialog::on_alert_table_changed(int row, int column)
+{
+	ASSERT_THREAD(OBS_TASK_UI);
+
+	if (row < 0 || (int)config.alerts.size() <= row)
+		return;
+
+	auto *item = alertTable->item(row, column);
+	if (!item)
+		return;
+
+	auto &alert = config.alerts[row];
+	double *value = nullptr;
+	switch (column) {
+	case 0:
+		alert.name = item->text().toUtf8().constData();
+		break;
+	case 1:
+		alert.tab = item->text().trimmed().toUtf8().constData();
+		break;
+	case 3:
+		value = &alert.threshold;
+		break;
+	case 4:
+		value = &alert.tolerance;
+		break;
+	case 5:
+		value = &alert.duration;
+		break;
+	}
+
+	if (value) {
+		bool ok = false;
+		double v = item->text().toDouble(&ok);
+		if (ok && (column == 3 || v >= 0.0))
+			*value = v;
+		else
+			item->setText(QString::number(*value, 'f', 1));
+	}
+
 	changed();
 }
 
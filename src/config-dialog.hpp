@@ -23,19 +23,34 @@ public slots:
 
 private:
 	void on_abbrev_label_changed(bool checked);
+	void on_overview_changed(bool checked);
+	void on_session_log_changed(bool checked);
+	void on_event_interval_changed(int interval_ms);
+	void on_idle_refresh_changed(int interval_ms);
+	void on_graph_minutes_changed(int minutes);
 	void on_tab_table_changed(int row, int column);
 	void on_tab_table_add();
 	void on_tab_table_remove();
+	void on_alert_table_changed(int row, int column);
+	void on_alert_table_add();
+	void on_alert_table_remove();
 	void on_color_table_changed(int row, int column);
 	void on_color_table_add();
 	void on_color_table_remove();
 
 	void TabTableAdd(int ix, const struct loudness_dock_config_s::tab_config &tab);
+	void AlertTableAdd(int ix, const struct loudness_dock_config_s::alert_config &alert);
 	void ColorTableAdd(int ix, float threshold, uint32_t color_fg, uint32_t color_bg);
 
 private:
 	class QCheckBox *abbrevLabelCheck;
+	class QCheckBox *overviewCheck;
+	class QCheckBox *sessionLogCheck;
+	class QSpinBox *eventIntervalSpin;
+	class QSpinBox *idleRefreshSpin;
+	class QSpinBox *graphMinutesSpin;
 	class QTableWidget *tabTable;
+	class QTableWidget *alertTable;
 	class QTableWidget *colorTable;
 
 	loudness_dock_config_s config;
@@ -11,17 +11,75 @@ struct loudness_dock_config_s
 		trigger_both = 3,
 	};
 
+	enum gating_mode_e {
+		gating_exact = 0,
+		gating_histogram = 1,
+	};
+
+	/* Same values as `enum loudness_peak_mode` */
+	enum peak_mode_e {
+		peak_true_4x = 0,
+		peak_true_2x = 1,
+		peak_sample = 2,
+		peak_off = 3,
+	};
+
 	struct tab_config
 	{
 		std::string name;
 		int track = 0;
+		/* Measures the source of the name instead of the track if not empty. */
+		std::string source;
 		trigger_mode_e trigger_mode = trigger_none;
+		gating_mode_e gating_mode = gating_exact;
+		peak_mode_e peak_mode = peak_true_4x;
+	};
+
+	/* Same values as `enum alert_condition` */
+	enum alert_condition_e {
+		alert_short_below = 0,
+		alert_short_above = 1,
+		alert_peak_over = 2,
+		alert_integrated_drift = 3,
+	};
+
+	struct alert_config
+	{
+		std::string name;
+		/* Applies to every tab if empty. */
+		std::string tab;
+		alert_condition_e condition = alert_short_below;
+		/* LUFS, or dB for the peak. The target for the drift. */
+		double threshold = -36.0;
+		/* LU, used only by the drift. */
+		double tolerance = 1.0;
+		/* Seconds that the condition has to continue */
+		double duration = 10.0;
 	};
 
 	bool abbrev_label = false;
 
+	/* Shows the momentary, short-term, and integrated loudness of all the tabs at once. */
+	bool overview = false;
+
+	/* Writes the loudness of every block of each tab to a CSV file. */
+	bool session_log = false;
+
+	/* Interval of the vendor events of obs-websocket. No event unless subscribed if 0. */
+	int event_interval_ms = 0;
+
+	/* Interval to refresh the dock while no block arrives, such as the tab is paused.
+	 * Otherwise the dock is refreshed by each block of 100 ms. At most 1000 to update at least 1 Hz. */
+	int idle_refresh_ms = 1000;
+
+	/* Span of the history graph. The graph is hidden if 0. */
+	int graph_minutes = 0;
+
 	std::vector<tab_config> tabs;
 
+	/* Evaluated while the trigger of the tab is active */
+	std::vector<alert_config> alerts;
+
 	std::vector<float> bar_thresholds;
 	std::vector<uint32_t> bar_fg_colors;
 	std::vector<uint32_t> bar_bg_colors;
@@ -0,0 +1,415 @@
+/*
+Loudness Dock for OBS Studio
+Copyright (C) 2025 Norihiro Kamae <norihiro@nagater.net>
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#include <stdlib.h>
+#include <obs-module.h>
+#include <util/threading.h>
+#include "gating.h"
+
+#define HISTOGRAM_BINS 1000
+
+typedef DARRAY(double) double_array_t;
+
+/* Blocks of one bin of 0.1 LU in the exact mode, in the order they were added */
+struct gating_bucket
+{
+	double sum;
+	double_array_t blocks;
+	/* Number of the blocks already written to the journal of the snapshot */
+	size_t saved;
+};
+
+struct gating
+{
+	enum gating_mode mode;
+
+	/* Blocks above the absolute gate */
+	double sum;
+	size_t count;
+
+	/* GATING_MODE_EXACT
+	 * A block is appended to the bucket of the histogram bin it falls in, so that adding a block never moves
+	 * the others. A gate sums the buckets above the bin of its threshold and compares only the blocks in that
+	 * bin. `scratch` is reused to pick the percentiles from one bucket. */
+	struct gating_bucket *buckets;
+	double_array_t scratch;
+
+	/* GATING_MODE_HISTOGRAM */
+	uint32_t *histogram;
+};
+
+/* Same layout as libebur128: 0.1 LU bins from -70 LUFS.
+ * Blocks louder than +30 LUFS fall into the last bin. */
+static double histogram_boundaries[HISTOGRAM_BINS + 1];
+static double histogram_energies[HISTOGRAM_BINS];
+static pthread_once_t histogram_once = PTHREAD_ONCE_INIT;
+
+static void init_histogram_tables(void)
+{
+	for (int i = 0; i <= HISTOGRAM_BINS; i++)
+		histogram_boundaries[i] = gating_energy_from_lufs(i / 10.0 - 70.0);
+	for (int i = 0; i < HISTOGRAM_BINS; i++)
+		histogram_energies[i] = gating_energy_from_lufs(i / 10.0 - 69.95);
+}
+
+static size_t histogram_index(double energy)
+{
+	size_t lo = 0, hi = HISTOGRAM_BINS;
+	while (hi - lo > 1) {
+		size_t mid = (lo + hi) / 2;
+		if (energy >= histogram_boundaries[mid])
+			lo = mid;
+		else
+			hi = mid;
+	}
+	return lo;
+}
+
+gating_t *gating_create(enum gating_mode mode)
+{
+	pthread_once(&histogram_once, init_histogram_tables);
+
+	gating_t *g = bzalloc(sizeof(gating_t));
+	g->mode = mode;
+	if (mode == GATING_MODE_HISTOGRAM)
+		g->histogram = bzalloc(sizeof(uint32_t) * HISTOGRAM_BINS);
+	else
+		g->buckets = bzalloc(sizeof(struct gating_bucket) * HISTOGRAM_BINS);
+
+	return g;
+}
+
+void gating_destroy(gating_t *g)
+{
+	if (!g)
+		return;
+
+	if (g->buckets) {
+		for (size_t i = 0; i < HISTOGRAM_BINS; i++)
+			da_free(g->buckets[i].blocks);
+		bfree(g->buckets);
+	}
+	da_free(g->scratch);
+	bfree(g->histogram);
+	bfree(g);
+}
+
+void gating_reset(gating_t *g)
+{
+	g->sum = 0.0;
+	g->count = 0;
+	if (g->buckets) {
+		for (size_t i = 0; i < HISTOGRAM_BINS; i++) {
+			g->buckets[i].sum = 0.0;
+			da_resize(g->buckets[i].blocks, 0);
+			g->buckets[i].saved = 0;
+		}
+	}
+	if (g->histogram)
+		memset(g->histogram, 0, sizeof(uint32_t) * HISTOGRAM_BINS);
+}
+
+enum gating_mode gating_get_mode(const gating_t *g)
+{
+	return g->mode;
+}
+
+void gating_add(gating_t *g, double energy)
+{
+	/* Absolute gate at -70 LUFS */
+	if (energy < histogram_boundaries[0])
+		return;
+
+	g->sum += energy;
+	g->count++;
+
+	const size_t ix = histogram_index(energy);
+	if (g->histogram) {
+		g->histogram[ix]++;
+	}
+	else {
+		struct gating_bucket *b = &g->buckets[ix];
+		b->sum += energy;
+		da_push_back(b->blocks, &energy);
+	}
+}
+
+/* Sums the blocks that are not less than `threshold`. All the blocks above the bin of `threshold` pass the gate,
+ * and only the blocks in that bin are compared. */
+static void sum_exact(const gating_t *g, double threshold, double *sum, size_t *count)
+{
+	const size_t start = histogram_index(threshold);
+
+	for (size_t i = start + 1; i < HISTOGRAM_BINS; i++) {
+		*sum += g->buckets[i].sum;
+		*count += g->buckets[i].blocks.num;
+	}
+
+	const double_array_t *blocks = &g->buckets[start].blocks;
+	for (size_t i = 0; i < blocks->num; i++) {
+		if (blocks->array[i] >= threshold) {
+			*sum += blocks->array[i];
+			(*count)++;
+		}
+	}
+}
+
+double gating_integrated(const gating_t *g)
+{
+	if (!g->count)
+		return -HUGE_VAL;
+
+	/* Relative gate at -10 LU */
+	const double threshold = g->sum / (double)g->count * 0.1;
+
+	double sum = 0.0;
+	size_t count = 0;
+
+	if (g->histogram) {
+		size_t start = histogram_index(threshold);
+		if (threshold > histogram_energies[start])
+			start++;
+		for (size_t i = start; i < HISTOGRAM_BINS; i++) {
+			sum += g->histogram[i] * histogram_energies[i];
+			count += g->histogram[i];
+		}
+	}
+	else {
+		sum_exact(g, threshold, &sum, &count);
+	}
+
+	if (!count)
+		return -HUGE_VAL;
+
+	return gating_lufs_from_energy(sum / (double)count);
+}
+
+static int compare_double(const void *a, const void *b)
+{
+	const double x = *(const double *)a, y = *(const double *)b;
+	return (x > y) - (x < y);
+}
+
+/* Sorts the blocks of the bucket `ix` that are not less than `threshold` into `scratch`. */
+static void sort_bucket(gating_t *g, size_t ix, double threshold)
+{
+	const double_array_t *blocks = &g->buckets[ix].blocks;
+	da_resize(g->scratch, 0);
+	for (size_t i = 0; i < blocks->num; i++) {
+		if (blocks->array[i] >= threshold)
+			da_push_back(g->scratch, &blocks->array[i]);
+	}
+	qsort(g->scratch.array, g->scratch.num, sizeof(double), compare_double);
+}
+
+/* Returns the blocks at the indices `ix[0]` and `ix[1]` of the blocks that are not less than `threshold`
+ * in ascending order. Only the buckets holding them are sorted. */
+static void pick_exact(gating_t *g, double threshold, const size_t ix[2], double values[2])
+{
+	size_t bucket = histogram_index(threshold);
+	sort_bucket(g, bucket, threshold);
+	size_t sorted = bucket;
+	size_t acc = 0;
+	size_t n = g->scratch.num;
+
+	for (int k = 0; k < 2; k++) {
+		while (acc + n <= ix[k]) {
+			acc += n;
+			n = g->buckets[++bucket].blocks.num;
+		}
+		if (sorted != bucket) {
+			sort_bucket(g, bucket, threshold);
+			sorted = bucket;
+		}
+		values[k] = g->scratch.array[ix[k] - acc];
+	}
+}
+
+static double range_exact(gating_t *g, double threshold)
+{
+	double sum = 0.0;
+	size_t count = 0;
+	sum_exact(g, threshold, &sum, &count);
+	if (!count)
+		return 0.0;
+
+	const size_t ix[2] = {(size_t)((count - 1) * 0.1 + 0.5), (size_t)((count - 1) * 0.95 + 0.5)};
+	double values[2];
+	pick_exact(g, threshold, ix, values);
+
+	return gating_lufs_from_energy(values[1]) - gating_lufs_from_energy(values[0]);
+}
+
+static double range_histogram(const gating_t *g, double threshold)
+{
+	size_t start = histogram_index(threshold);
+	if (threshold > histogram_energies[start])
+		start++;
+
+	size_t count = 0;
+	for (size_t i = start; i < HISTOGRAM_BINS; i++)
+		count += g->histogram[i];
+	if (!count)
+		return 0.0;
+
+	const size_t ix_low = (size_t)((count - 1) * 0.1 + 0.5);
+	const size_t ix_high = (size_t)((count - 1) * 0.95 + 0.5);
+	size_t low = start, high = start;
+	size_t acc = 0;
+	for (size_t i = start; i < HISTOGRAM_BINS; i++) {
+		if (acc <= ix_low)
+			low = i;
+		acc += g->histogram[i];
+		if (acc > ix_high) {
+			high = i;
+			break;
+		}
+	}
+
+	return (high - low) / 10.0;
+}
+
+double gating_range(gating_t *g)
+{
+	if (!g->count)
+		return 0.0;
+
+	/* Relative gate at -20 LU */
+	const double threshold = g->sum / (double)g->count * 0.01;
+
+	if (g->histogram)
+		return range_histogram(g, threshold);
+	else
+		return range_exact(g, threshold);
+}
+
+/* Layout of a snapshot, followed by `n` bins in uint32_t in the histogram mode.
+ * In the exact mode, the `n` blocks are in the journal. */
+struct gating_snapshot
+{
+	uint32_t mode;
+	uint32_t reserved;
+	double sum;
+	uint64_t count;
+	uint64_t n;
+};
+
+/* Layout of the journal, followed by `n` blocks in double */
+struct gating_journal_chunk
+{
+	uint32_t id;
+	uint32_t n;
+};
+
+void gating_restart_journal(gating_t *g)
+{
+	if (g->buckets) {
+		for (size_t i = 0; i < HISTOGRAM_BINS; i++)
+			g->buckets[i].saved = 0;
+	}
+}
+
+/* Appends the blocks that are not in the journal yet. */
+static void save_journal(gating_t *g, snapshot_buffer_t *journal, uint32_t id)
+{
+	size_t n = 0;
+	for (size_t i = 0; i < HISTOGRAM_BINS; i++)
+		n += g->buckets[i].blocks.num - g->buckets[i].saved;
+	if (!n)
+		return;
+
+	const struct gating_journal_chunk chunk = {.id = id, .n = (uint32_t)n};
+	snapshot_write(journal, &chunk, sizeof(chunk));
+
+	for (size_t i = 0; i < HISTOGRAM_BINS; i++) {
+		struct gating_bucket *b = &g->buckets[i];
+		snapshot_write(journal, b->blocks.array + b->saved, sizeof(double) * (b->blocks.num - b->saved));
+		b->saved = b->blocks.num;
+	}
+}
+
+/* Adds the blocks of `id` in the journal. */
+static bool load_journal(gating_t *g, const struct snapshot_reader *journal, uint32_t id)
+{
+	struct snapshot_reader r = *journal;
+	r.pos = 0;
+
+	while (r.pos < r.size) {
+		struct gating_journal_chunk chunk;
+		if (!snapshot_read_data(&r, &chunk, sizeof(chunk)) || chunk.n > (r.size - r.pos) / sizeof(double))
+			return false;
+
+		if (chunk.id != id) {
+			r.pos += sizeof(double) * chunk.n;
+			continue;
+		}
+
+		for (uint32_t i = 0; i < chunk.n; i++) {
+			double energy;
+			snapshot_read_data(&r, &energy, sizeof(energy));
+			gating_add(g, energy);
+		}
+	}
+
+	return true;
+}
+
+void gating_save(gating_t *g, snapshot_buffer_t *buf, snapshot_buffer_t *journal, uint32_t id)
+{
+	struct gating_snapshot s = {
+		.mode = (uint32_t)g->mode,
+		.sum = g->sum,
+		.count = g->count,
+		.n = g->histogram ? HISTOGRAM_BINS : g->count,
+	};
+	snapshot_write(buf, &s, sizeof(s));
+
+	if (g->histogram)
+		snapshot_write(buf, g->histogram, sizeof(uint32_t) * HISTOGRAM_BINS);
+	else
+		save_journal(g, journal, id);
+}
+
+bool gating_load(gating_t *g, struct snapshot_reader *r, const struct snapshot_reader *journal, uint32_t id)
+{
+	gating_reset(g);
+
+	struct gating_snapshot s;
+	if (!snapshot_read_data(r, &s, sizeof(s)) || s.mode != (uint32_t)g->mode)
+		return false;
+
+	bool ok;
+	if (g->histogram) {
+		ok = s.n == HISTOGRAM_BINS && snapshot_read_data(r, g->histogram, sizeof(uint32_t) * HISTOGRAM_BINS);
+	}
+	else {
+		/* The blocks were appended bucket by bucket. Each bucket gets the same blocks in the same order so
+		 * that the sums of the buckets are same as before. */
+		ok = s.n == s.count && load_journal(g, journal, id) && g->count == s.count;
+	}
+
+	if (!ok) {
+		gating_reset(g);
+		return false;
+	}
+
+	g->sum = s.sum;
+	g->count = (size_t)s.count;
+	return true;
+}
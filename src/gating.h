@@ -0,0 +1,67 @@
+#pragma once
+
+#include <math.h>
+#include "snapshot.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Accumulates gating blocks for the integrated loudness and the loudness range.
+ *
+ * In the exact mode, every block above the absolute gate is appended to the bucket of its 0.1 LU bin
+ * so that adding a block costs the same however long the session is. The gates sum the buckets
+ * above the bin of the threshold and compare only the blocks of that bin; the loudness range sorts
+ * only the buckets holding its percentiles.
+ * In the histogram mode, the blocks are counted in 0.1 LU bins from -70 LUFS to +30 LUFS
+ * so that the memory and the query time do not depend on the length of the session. */
+typedef struct gating gating_t;
+
+enum gating_mode {
+	GATING_MODE_EXACT = 0,
+	GATING_MODE_HISTOGRAM = 1,
+};
+
+gating_t *gating_create(enum gating_mode mode);
+void gating_destroy(gating_t *g);
+/* Clears the blocks in place. The storage is kept so that a reset does not touch the allocator. */
+void gating_reset(gating_t *g);
+
+/* Adds a block. `energy` is the mean square of the K-weighted and channel-weighted signal. */
+void gating_add(gating_t *g, double energy);
+
+/* Returns the integrated loudness in LUFS with the relative gate of -10 LU,
+ * or -HUGE_VAL if no block is above the gates. */
+double gating_integrated(const gating_t *g);
+
+/* Returns the loudness range in LU with the relative gate of -20 LU. */
+double gating_range(gating_t *g);
+
+enum gating_mode gating_get_mode(const gating_t *g);
+
+/* Appends the state to a snapshot. In the exact mode, the blocks added since the last call are appended to
+ * `journal` tagged by `id` so that the gatings of a snapshot can share one journal. */
+void gating_save(gating_t *g, snapshot_buffer_t *buf, snapshot_buffer_t *journal, uint32_t id);
+
+/* The next `gating_save` appends all the blocks, such as when the journal was discarded. */
+void gating_restart_journal(gating_t *g);
+
+/* Replaces the blocks by the ones saved by `gating_save` with the same `id`.
+ * Returns false if the data is broken or saved in the other mode, then `g` is left reset. */
+bool gating_load(gating_t *g, struct snapshot_reader *r, const struct snapshot_reader *journal, uint32_t id);
+
+static inline double gating_energy_from_lufs(double lufs)
+{
+	return pow(10.0, (lufs + 0.691) / 10.0);
+}
+
+static inline double gating_lufs_from_energy(double energy)
+{
+	if (energy <= 0.0)
+		return -HUGE_VAL;
+	return 10.0 * log10(energy) - 0.691;
+}
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
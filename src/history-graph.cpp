@@ -0,0 +1,354 @@
+/*
+Loudness Dock for OBS Studio
+Copyright (C) 2025 Norihiro Kamae <norihiro@nagater.net>
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#include <algorithm>
+#include <cmath>
+#include <obs-module.h>
+#include <obs.h>
+#include <util/platform.h>
+#include <vector>
+#include <QPainter>
+#include <QPaintEvent>
+#include <QPixmap>
+#ifdef ENABLE_PROFILE
+#include <util/profiler.hpp>
+#endif
+#include "history-graph.hpp"
+#include "utils.hpp"
+#include "history.h"
+
+#include "plugin-macros.generated.h"
+
+/* The dock refreshes at least every second while it is visible. A longer interval is a gap. */
+#define GAP_NS 2000000000ULL
+
+struct graph_color_s
+{
+	float level;
+	QColor color_fg;
+	QColor color_bg;
+};
+
+struct graph_column_s
+{
+	float momentary = -HUGE_VALF;
+	float short_term = -HUGE_VALF;
+	float integrated = -HUGE_VALF;
+};
+
+/* Drawn as the background, and the lines are not joined across it. */
+static const graph_column_s gap_column = {NAN, NAN, NAN};
+
+struct history_graph_data
+{
+	float min = -59.0f;
+	float max = -5.0f;
+	uint64_t span_ns = 5 * 60 * 1000000000ULL;
+
+	std::vector<graph_color_s> colors;
+	QColor color_short = QColor(255, 255, 255);
+	QColor color_integrated = QColor(255, 255, 0);
+
+	/* In device pixels. `columns[x]` is drawn at `x` of `pixmap`. The newest column is at `write_x - 1`. */
+	QPixmap pixmap;
+	std::vector<graph_column_s> columns;
+	int write_x = 0;
+
+	/* The columns are numbered by `os_gettime_ns() / column_ns`. */
+	uint64_t column_ns = 0;
+	uint64_t last_column = 0;
+	/* Time of the last values, or 0 to request the history */
+	uint64_t last_ns = 0;
+
+	/* Accumulated for `last_column + 1` */
+	graph_column_s pending;
+
+	inline int toY(float value, int height) const
+	{
+		if (!(value >= min))
+			value = min;
+		if (value >= max)
+			value = max;
+		float y = (max - value) / (max - min);
+		return (int)((height - 1) * y);
+	}
+};
+
+HistoryGraph::HistoryGraph(QWidget *parent) : QWidget(parent), data(*new struct history_graph_data)
+{
+	ASSERT_THREAD(OBS_TASK_UI);
+
+	data.colors.push_back({-23.0, QColor(0, 0, 255), QColor(0, 0, 85)});
+	data.colors.push_back({-14.0, QColor(0, 255, 0), QColor(0, 85, 0)});
+	data.colors.push_back({0.0, QColor(255, 0, 0), QColor(85, 0, 0)});
+
+	setMinimumSize(64, 48);
+	setAttribute(Qt::WA_OpaquePaintEvent);
+}
+
+HistoryGraph::~HistoryGraph()
+{
+	ASSERT_THREAD(OBS_TASK_UI);
+
+	delete &data;
+}
+
+void HistoryGraph::setRange(float min, float max)
+{
+	ASSERT_THREAD(OBS_TASK_UI);
+
+	data.min = min;
+	data.max = max;
+
+	rebuild();
+}
+
+void HistoryGraph::setColors(const float *levels, const uint32_t *fg_colors, const uint32_t *bg_colors,
+			     uint32_t n_colors)
+{
+	ASSERT_THREAD(OBS_TASK_UI);
+
+	data.colors.resize(n_colors);
+
+	for (uint32_t i = 0; i < n_colors; i++) {
+		data.colors[i].level = i < n_colors - 1 ? levels[i] : data.max;
+		data.colors[i].color_fg = color_from_int(fg_colors[i]);
+		data.colors[i].color_bg = color_from_int(bg_colors[i]);
+	}
+
+	rebuild();
+}
+
+void HistoryGraph::setSpan(int seconds)
+{
+	ASSERT_THREAD(OBS_TASK_UI);
+
+	const uint64_t span_ns = (uint64_t)std::max(seconds, 1) * 1000000000ULL;
+	if (span_ns == data.span_ns)
+		return;
+
+	/* The columns have a different duration. Start over. */
+	data.span_ns = span_ns;
+	clear();
+}
+
+void HistoryGraph::clear()
+{
+	ASSERT_THREAD(OBS_TASK_UI);
+
+	std::fill(data.columns.begin(), data.columns.end(), gap_column);
+	data.pending = graph_column_s();
+	data.last_column = 0;
+	data.last_ns = 0;
+
+	rebuild();
+}
+
+void HistoryGraph::addValues(float momentary, float short_term, float integrated)
+{
+	ASSERT_THREAD(OBS_TASK_UI);
+
+	const int width = (int)data.columns.size();
+	if (!width || data.pixmap.isNull())
+		return;
+
+	const uint64_t now = os_gettime_ns();
+	const uint64_t column = now / data.column_ns;
+
+	if (!data.last_ns || now - data.last_ns > GAP_NS) {
+		/* Nothing was seen since the last values. */
+		advance(column - 1, true);
+		emit historyRequested();
+	}
+	data.last_ns = now;
+
+	auto &p = data.pending;
+	if (momentary > p.momentary)
+		p.momentary = momentary;
+	p.short_term = short_term;
+	p.integrated = integrated;
+
+	if (column > data.last_column + 1) {
+		advance(column - 1, false);
+		update();
+	}
+}
+
+/* Draws the columns until `column`, either the pending values or gaps. The pending values are drawn to more
+ * than one column if the ticks are longer than a column. */
+void HistoryGraph::advance(uint64_t column, bool gap)
+{
+	const int width = (int)data.columns.size();
+	if (column <= data.last_column)
+		return;
+	if (column - data.last_column > (uint64_t)width)
+		data.last_column = column - width;
+
+	QPainter painter(&data.pixmap);
+	const graph_column_s value = gap ? gap_column : data.pending;
+	for (; data.last_column < column; data.last_column++) {
+		data.columns[data.write_x] = value;
+		drawColumn(painter, data.write_x);
+		data.write_x = (data.write_x + 1) % width;
+	}
+
+	data.pending = graph_column_s();
+}
+
+void HistoryGraph::setHistory(const struct history_result &result)
+{
+	ASSERT_THREAD(OBS_TASK_UI);
+
+	const int width = (int)data.columns.size();
+	if (!width)
+		return;
+
+	/* The oldest column is at 0. */
+	const uint64_t column = os_gettime_ns() / data.column_ns;
+	const uint64_t first_column = column - width;
+	std::fill(data.columns.begin(), data.columns.end(), gap_column);
+	data.pending = graph_column_s();
+	data.write_x = 0;
+	data.last_column = column - 1;
+
+	for (size_t i = 0; i < result.n_segments; i++) {
+		const struct history_segment &seg = result.segments[i];
+		for (size_t j = 0; j < seg.count; j++) {
+			const uint64_t t_ms = seg.start_ms + (uint64_t)j * result.interval_ms;
+			const uint64_t c = t_ms * 1000000ULL / data.column_ns;
+			if (c < first_column)
+				continue;
+
+			graph_column_s &v = c >= column ? data.pending : data.columns[c - first_column];
+			if (std::isnan(v.momentary))
+				v = graph_column_s();
+
+			const float momentary = (float)history_decode(result.momentary[seg.offset + j]);
+			if (momentary > v.momentary)
+				v.momentary = momentary;
+			v.short_term = (float)history_decode(result.short_term[seg.offset + j]);
+		}
+	}
+
+	rebuild();
+}
+
+void HistoryGraph::drawColumn(QPainter &painter, int x)
+{
+	const int width = (int)data.columns.size();
+	const int height = data.pixmap.height();
+	const graph_column_s &c = data.columns[x];
+	const graph_column_s &prev = data.columns[(x + width - 1) % width];
+
+	/* Background bands, and the momentary loudness filled from the bottom */
+	const int y_momentary = c.momentary > data.min ? data.toY(c.momentary, height) : height;
+	int last = height;
+	for (const auto &color : data.colors) {
+		const int y_level = data.toY(color.level, height);
+		if (y_level >= last)
+			continue;
+
+		if (y_momentary < last) {
+			const int top = std::max(y_momentary, y_level);
+			painter.fillRect(x, top, 1, last - top, color.color_fg);
+		}
+		if (y_level < y_momentary) {
+			const int bottom = std::min(y_momentary, last);
+			painter.fillRect(x, y_level, 1, bottom - y_level, color.color_bg);
+		}
+
+		last = y_level;
+	}
+	if (last > 0)
+		painter.fillRect(x, 0, 1, last, data.colors.size() ? data.colors.back().color_bg : QColor(0, 0, 0));
+
+	/* The short-term and the integrated loudness as lines joining the previous column */
+	auto draw_line = [&](float v, float v_prev, const QColor &color) {
+		if (!(v > data.min))
+			return;
+		const int y = data.toY(v, height);
+		const int y_prev = v_prev > data.min ? data.toY(v_prev, height) : y;
+		painter.fillRect(x, std::min(y, y_prev), 1, std::abs(y - y_prev) + 1, color);
+	};
+	draw_line(c.short_term, prev.short_term, data.color_short);
+	draw_line(c.integrated, prev.integrated, data.color_integrated);
+}
+
+void HistoryGraph::rebuild()
+{
+	const qreal dpr = devicePixelRatioF();
+	const int width = std::max((int)(rect().width() * dpr), 1);
+	const int height = std::max((int)(rect().height() * dpr), 1);
+
+	if (width != (int)data.columns.size()) {
+		/* The columns have a different duration. Request the history again. */
+		data.columns.assign(width, gap_column);
+		data.write_x = 0;
+		data.last_column = 0;
+		data.last_ns = 0;
+	}
+
+	data.column_ns = std::max(data.span_ns / (uint64_t)width, (uint64_t)1);
+
+	if (data.pixmap.width() != width || data.pixmap.height() != height)
+		data.pixmap = QPixmap(width, height);
+
+	/* The only place that draws all the columns */
+	QPainter painter(&data.pixmap);
+	for (int x = 0; x < width; x++)
+		drawColumn(painter, (data.write_x + x) % width);
+
+	update();
+}
+
+void HistoryGraph::resizeEvent(QResizeEvent *event)
+{
+	ASSERT_THREAD(OBS_TASK_UI);
+
+	QWidget::resizeEvent(event);
+	rebuild();
+}
+
+#ifdef ENABLE_PROFILE
+static const char *name_paintEvent = "HistoryGraph::paintEvent";
+#endif
+
+void HistoryGraph::paintEvent(QPaintEvent *)
+{
+#ifdef ENABLE_PROFILE
+	ScopeProfiler profiler(name_paintEvent);
+#endif
+	ASSERT_THREAD(OBS_TASK_UI);
+
+	if (data.pixmap.isNull())
+		return;
+
+	/* The oldest column is at `write_x`. Blit the ring in two parts. */
+	const qreal dpr = data.pixmap.width() / (qreal)std::max(rect().width(), 1);
+	const int width = data.pixmap.width();
+	const int height = data.pixmap.height();
+	const int right = width - data.write_x;
+
+	QPainter painter(this);
+	painter.drawPixmap(QRectF(0, 0, right / dpr, rect().height()), data.pixmap,
+			   QRectF(data.write_x, 0, right, height));
+	if (data.write_x > 0)
+		painter.drawPixmap(QRectF(right / dpr, 0, data.write_x / dpr, rect().height()), data.pixmap,
+				   QRectF(0, 0, data.write_x, height));
+}
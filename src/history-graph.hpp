@@ -0,0 +1,41 @@
+#pragma once
+#include <QWidget>
+
+struct history_result;
+
+/* Timeline of the momentary, the short-term, and the integrated loudness of the last minutes.
+ *
+ * Each column of the device pixels covers `span / width` seconds. The columns are drawn once
+ * into an offscreen pixmap used as a ring so that a tick draws only the newest column and
+ * the paint event only blits the two parts of the ring.
+ * A column without any value, such as while the dock was hidden, is a gap. After a gap, a clear, or a resize,
+ * `historyRequested` is emitted so that the columns are filled from the history by `setHistory`. */
+class HistoryGraph : public QWidget {
+	Q_OBJECT
+
+public:
+	HistoryGraph(QWidget *parent = nullptr);
+	~HistoryGraph();
+
+	void setRange(float min, float max);
+	void setColors(const float *levels, const uint32_t *fg_colors, const uint32_t *bg_colors, uint32_t n_colors);
+	void setSpan(int seconds);
+	void addValues(float momentary, float short_term, float integrated);
+	/* Replaces the columns by the blocks of `result`. The integrated loudness is not in the history. */
+	void setHistory(const struct history_result &result);
+	void clear();
+
+signals:
+	void historyRequested();
+
+protected:
+	void paintEvent(QPaintEvent *event) override;
+	void resizeEvent(QResizeEvent *event) override;
+
+private:
+	void rebuild();
+	void advance(uint64_t column, bool gap);
+	void drawColumn(class QPainter &painter, int x);
+
+	struct history_graph_data &data;
+};
@@ -0,0 +1,245 @@
+/*
+Loudness Dock for OBS Studio
+Copyright (C) 2025 Norihiro Kamae <norihiro@nagater.net>
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#include <obs-module.h>
+#include <util/threading.h>
+#include <util/darray.h>
+#include "history.h"
+
+/* One minute */
+#define CHUNK_BLOCKS 600
+
+struct chunk
+{
+	/* End of the first block. The following blocks are spaced by HISTORY_BLOCK_MS. */
+	uint64_t start_ms;
+	uint32_t count;
+	int16_t momentary[CHUNK_BLOCKS];
+	int16_t short_term[CHUNK_BLOCKS];
+};
+
+struct history
+{
+	pthread_mutex_t mutex;
+
+	/* Ring of the chunks from the oldest at `head` */
+	struct chunk **chunks;
+	size_t max_chunks;
+	size_t head;
+	size_t n;
+};
+
+history_t *history_create(uint32_t retention_seconds)
+{
+	history_t *h = bzalloc(sizeof(history_t));
+	pthread_mutex_init(&h->mutex, NULL);
+
+	const size_t blocks = (size_t)retention_seconds * 1000 / HISTORY_BLOCK_MS;
+	h->max_chunks = (blocks + CHUNK_BLOCKS - 1) / CHUNK_BLOCKS + 1;
+	h->chunks = bzalloc(sizeof(struct chunk *) * h->max_chunks);
+
+	return h;
+}
+
+void history_destroy(history_t *h)
+{
+	if (!h)
+		return;
+
+	for (size_t i = 0; i < h->max_chunks; i++)
+		bfree(h->chunks[i]);
+	bfree(h->chunks);
+	pthread_mutex_destroy(&h->mutex);
+	bfree(h);
+}
+
+static inline struct chunk *chunk_at(const history_t *h, size_t i)
+{
+	return h->chunks[(h->head + i) % h->max_chunks];
+}
+
+/* Returns the chunk to be appended, recycling the oldest one if the retention is reached. */
+static struct chunk *new_chunk(history_t *h, uint64_t start_ms)
+{
+	struct chunk *c;
+	if (h->n < h->max_chunks) {
+		const size_t ix = (h->head + h->n) % h->max_chunks;
+		if (!h->chunks[ix])
+			h->chunks[ix] = bmalloc(sizeof(struct chunk));
+		c = h->chunks[ix];
+		h->n++;
+	}
+	else {
+		c = h->chunks[h->head];
+		h->head = (h->head + 1) % h->max_chunks;
+	}
+
+	c->start_ms = start_ms;
+	c->count = 0;
+	return c;
+}
+
+void history_add(history_t *h, uint64_t timestamp_ms, double momentary, double short_term, bool restart)
+{
+	pthread_mutex_lock(&h->mutex);
+
+	struct chunk *c = h->n ? chunk_at(h, h->n - 1) : NULL;
+	if (!c || restart) {
+		c = new_chunk(h, timestamp_ms);
+	}
+	else if (c->count >= CHUNK_BLOCKS) {
+		/* Each chunk is anchored to the wall clock so that the clock of the audio does not accumulate a drift.
+		 * The segment continues unless the drift reaches a block. */
+		const uint64_t next_ms = c->start_ms + (uint64_t)c->count * HISTORY_BLOCK_MS;
+		const uint64_t drift = timestamp_ms > next_ms ? timestamp_ms - next_ms : next_ms - timestamp_ms;
+		c = new_chunk(h, drift < HISTORY_BLOCK_MS ? next_ms : timestamp_ms);
+	}
+
+	c->momentary[c->count] = history_encode(momentary);
+	c->short_term[c->count] = history_encode(short_term);
+	c->count++;
+
+	pthread_mutex_unlock(&h->mutex);
+}
+
+static inline int16_t max_value(int16_t a, int16_t b)
+{
+	/* HISTORY_NO_VALUE is the smallest. */
+	return a > b ? a : b;
+}
+
+/* Returns the range of the blocks of `c` ending in [`since_ms`, `until_ms`). */
+static inline void chunk_range(const struct chunk *c, uint64_t since_ms, uint64_t until_ms, uint32_t *first,
+			       uint32_t *last)
+{
+	uint64_t j0 = 0, j1 = 0;
+	if (since_ms > c->start_ms)
+		j0 = (since_ms - c->start_ms + HISTORY_BLOCK_MS - 1) / HISTORY_BLOCK_MS;
+	if (until_ms > c->start_ms)
+		j1 = (until_ms - c->start_ms + HISTORY_BLOCK_MS - 1) / HISTORY_BLOCK_MS;
+	*first = (uint32_t)(j0 < c->count ? j0 : c->count);
+	*last = (uint32_t)(j1 < c->count ? j1 : c->count);
+}
+
+void history_query(history_t *h, uint64_t since_ms, uint64_t until_ms, uint32_t decimate,
+		   struct history_result *result)
+{
+	if (decimate < 1)
+		decimate = 1;
+	const uint64_t interval = (uint64_t)decimate * HISTORY_BLOCK_MS;
+
+	DARRAY(struct history_segment) segments;
+	DARRAY(int16_t) momentary;
+	DARRAY(int16_t) short_term;
+	da_init(segments);
+	da_init(momentary);
+	da_init(short_term);
+
+	pthread_mutex_lock(&h->mutex);
+
+	/* Reserves for the worst case so that the copy below does not reallocate.
+	 * A segment begins at most once in each chunk and a group is split at most at both ends of a chunk. */
+	size_t max_segments = 0, max_values = 0;
+	for (size_t i = 0; i < h->n; i++) {
+		const struct chunk *c = chunk_at(h, i);
+		if (c->start_ms >= until_ms)
+			break;
+		uint32_t j0, j1;
+		chunk_range(c, since_ms, until_ms, &j0, &j1);
+		if (j0 >= j1)
+			continue;
+		max_segments++;
+		max_values += (j1 - j0) / decimate + 2;
+	}
+	da_reserve(segments, max_segments);
+	da_reserve(momentary, max_values);
+	da_reserve(short_term, max_values);
+
+	struct history_segment *seg = NULL;
+	uint64_t next_ms = 0; /* Expected time of the next block in the current segment */
+	uint64_t group = 0;
+
+	for (size_t i = 0; i < h->n; i++) {
+		const struct chunk *c = chunk_at(h, i);
+		if (c->start_ms >= until_ms)
+			break;
+
+		if (seg && c->start_ms != next_ms)
+			seg = NULL;
+		next_ms = c->start_ms + (uint64_t)c->count * HISTORY_BLOCK_MS;
+
+		uint32_t j0, j1;
+		chunk_range(c, since_ms, until_ms, &j0, &j1);
+		if (j0 >= j1)
+			continue;
+
+		if (!seg) {
+			seg = da_push_back_new(segments);
+			seg->start_ms = c->start_ms + (uint64_t)j0 * HISTORY_BLOCK_MS;
+			seg->offset = momentary.num;
+			seg->count = 0;
+			group = UINT64_MAX;
+		}
+
+		if (decimate == 1) {
+			/* Each block is a group. */
+			da_push_back_array(momentary, c->momentary + j0, j1 - j0);
+			da_push_back_array(short_term, c->short_term + j0, j1 - j0);
+			seg->count += j1 - j0;
+			continue;
+		}
+
+		for (uint32_t j = j0; j < j1; j++) {
+			const uint64_t t = c->start_ms + (uint64_t)j * HISTORY_BLOCK_MS;
+			const uint64_t g = t / interval;
+			if (g == group) {
+				int16_t *m = &momentary.array[momentary.num - 1];
+				int16_t *s = &short_term.array[short_term.num - 1];
+				*m = max_value(*m, c->momentary[j]);
+				*s = max_value(*s, c->short_term[j]);
+				/* The first point is labeled by the last block of its group. */
+				if (seg->count == 1)
+					seg->start_ms = t;
+				continue;
+			}
+
+			group = g;
+			da_push_back(momentary, &c->momentary[j]);
+			da_push_back(short_term, &c->short_term[j]);
+			seg->count++;
+		}
+	}
+
+	pthread_mutex_unlock(&h->mutex);
+
+	result->interval_ms = (uint32_t)interval;
+	result->n_segments = segments.num;
+	result->segments = segments.array;
+	result->n_values = momentary.num;
+	result->momentary = momentary.array;
+	result->short_term = short_term.array;
+}
+
+void history_result_free(struct history_result *result)
+{
+	bfree(result->segments);
+	bfree(result->momentary);
+	bfree(result->short_term);
+	memset(result, 0, sizeof(*result));
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <math.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Long-session store of the momentary and the short-term loudness.
+ *
+ * One entry is stored for every 100 ms block, each value in int16 of 0.01 LU so that
+ * 24 hours of a track take about 3.5 MB. Entries are kept in chunks of one minute in a ring;
+ * the oldest chunk is recycled once the retention is reached.
+ * The writer is the analysis thread. Queries can be made from any thread. */
+typedef struct history history_t;
+
+#define HISTORY_BLOCK_MS 100
+/* Stored for -inf, or for a group of decimated blocks without any value. */
+#define HISTORY_NO_VALUE INT16_MIN
+
+history_t *history_create(uint32_t retention_seconds);
+void history_destroy(history_t *h);
+
+/* Appends a block. `timestamp_ms` is the end of the block.
+ * The blocks are spaced by HISTORY_BLOCK_MS and `timestamp_ms` is taken as an anchor every minute.
+ * If `restart` is set or the anchor is a block or more away from the last block, a new segment begins. */
+void history_add(history_t *h, uint64_t timestamp_ms, double momentary, double short_term, bool restart);
+
+static inline int16_t history_encode(double lufs)
+{
+	if (!(lufs > -327.67))
+		return HISTORY_NO_VALUE;
+	if (lufs > 327.67)
+		return INT16_MAX;
+	double v = lufs * 100.0;
+	return (int16_t)(v < 0.0 ? v - 0.5 : v + 0.5);
+}
+
+static inline double history_decode(int16_t v)
+{
+	if (v == HISTORY_NO_VALUE)
+		return -HUGE_VAL;
+	return v * 0.01;
+}
+
+/* Blocks of the same segment are evenly spaced by `interval_ms`. */
+struct history_segment
+{
+	uint64_t start_ms;
+	size_t offset; /* index of the first value in `history_result` */
+	size_t count;
+};
+
+struct history_result
+{
+	uint32_t interval_ms;
+	size_t n_segments;
+	struct history_segment *segments;
+	size_t n_values;
+	int16_t *momentary;
+	int16_t *short_term;
+};
+
+/* Copies the blocks ending in [`since_ms`, `until_ms`).
+ * Every `decimate` blocks are merged into the loudest of them. The groups are aligned to
+ * the multiple of the interval so that repeated queries return the same points.
+ * The result has to be freed by `history_result_free`. */
+void history_query(history_t *h, uint64_t since_ms, uint64_t until_ms, uint32_t decimate,
+		   struct history_result *result);
+void history_result_free(struct history_result *result);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
@@ -0,0 +1,168 @@
+/*
+Loudness Dock for OBS Studio
+Copyright (C) 2025 Norihiro Kamae <norihiro@nagater.net>
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+/* Vectorized K-weighting filter. Each lane holds one channel so that the recursion of the
+ * filter is kept in time order. Multiplications and subtractions are in the same order as
+ * `kfilter_process` without FMA so that the results are bit-exact. */
+
+#include "kfilter.h"
+
+#ifdef KFILTER_X86
+
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define TARGET_AVX2
+#else
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+bool kfilter_cpu_has_sse2(void)
+{
+	/* Always available on x86_64 */
+	return true;
+}
+
+bool kfilter_cpu_has_avx2(void)
+{
+#ifdef _MSC_VER
+	int info[4];
+	__cpuid(info, 1);
+	const bool osxsave = (info[2] & (1 << 27)) != 0;
+	const bool avx = (info[2] & (1 << 28)) != 0;
+	if (!osxsave || !avx)
+		return false;
+	if ((_xgetbv(0) & 6) != 6)
+		return false;
+	__cpuidex(info, 7, 0);
+	return (info[1] & (1 << 5)) != 0;
+#else
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("avx2");
+#endif
+}
+
+/* Stores each lane of `reg` into `v[ix]` of the state of the channel */
+static inline void store_state_sse2(struct kfilter_state *const *s, int ix, __m128d reg)
+{
+	double tmp[2];
+	_mm_storeu_pd(tmp, reg);
+	s[0]->v[ix] = tmp[0];
+	s[1]->v[ix] = tmp[1];
+}
+
+void kfilter_process_sse2(const struct kfilter_coeffs *k, struct kfilter_state *const *s, const float *const *in,
+			  size_t n, double *sums)
+{
+	const __m128d a1 = _mm_set1_pd(k->a[1]), a2 = _mm_set1_pd(k->a[2]);
+	const __m128d a3 = _mm_set1_pd(k->a[3]), a4 = _mm_set1_pd(k->a[4]);
+	const __m128d b0 = _mm_set1_pd(k->b[0]), b1 = _mm_set1_pd(k->b[1]), b2 = _mm_set1_pd(k->b[2]);
+	const __m128d b3 = _mm_set1_pd(k->b[3]), b4 = _mm_set1_pd(k->b[4]);
+
+	__m128d v1 = _mm_set_pd(s[1]->v[1], s[0]->v[1]);
+	__m128d v2 = _mm_set_pd(s[1]->v[2], s[0]->v[2]);
+	__m128d v3 = _mm_set_pd(s[1]->v[3], s[0]->v[3]);
+	__m128d v4 = _mm_set_pd(s[1]->v[4], s[0]->v[4]);
+	__m128d sum = _mm_setzero_pd();
+
+	const float *in0 = in[0], *in1 = in[1];
+
+	for (size_t i = 0; i < n; i++) {
+		__m128d x = _mm_set_pd((double)in1[i], (double)in0[i]);
+		__m128d v0 = _mm_sub_pd(x, _mm_mul_pd(a1, v1));
+		v0 = _mm_sub_pd(v0, _mm_mul_pd(a2, v2));
+		v0 = _mm_sub_pd(v0, _mm_mul_pd(a3, v3));
+		v0 = _mm_sub_pd(v0, _mm_mul_pd(a4, v4));
+
+		__m128d y = _mm_mul_pd(b0, v0);
+		y = _mm_add_pd(y, _mm_mul_pd(b1, v1));
+		y = _mm_add_pd(y, _mm_mul_pd(b2, v2));
+		y = _mm_add_pd(y, _mm_mul_pd(b3, v3));
+		y = _mm_add_pd(y, _mm_mul_pd(b4, v4));
+
+		sum = _mm_add_pd(sum, _mm_mul_pd(y, y));
+
+		v4 = v3;
+		v3 = v2;
+		v2 = v1;
+		v1 = v0;
+	}
+
+	store_state_sse2(s, 1, v1);
+	store_state_sse2(s, 2, v2);
+	store_state_sse2(s, 3, v3);
+	store_state_sse2(s, 4, v4);
+
+	_mm_storeu_pd(sums, sum);
+}
+
+TARGET_AVX2 static inline void store_state_avx2(struct kfilter_state *const *s, int ix, __m256d reg)
+{
+	double tmp[4];
+	_mm256_storeu_pd(tmp, reg);
+	for (int c = 0; c < 4; c++)
+		s[c]->v[ix] = tmp[c];
+}
+
+TARGET_AVX2 void kfilter_process_avx2(const struct kfilter_coeffs *k, struct kfilter_state *const *s,
+				      const float *const *in, size_t n, double *sums)
+{
+	const __m256d a1 = _mm256_set1_pd(k->a[1]), a2 = _mm256_set1_pd(k->a[2]);
+	const __m256d a3 = _mm256_set1_pd(k->a[3]), a4 = _mm256_set1_pd(k->a[4]);
+	const __m256d b0 = _mm256_set1_pd(k->b[0]), b1 = _mm256_set1_pd(k->b[1]), b2 = _mm256_set1_pd(k->b[2]);
+	const __m256d b3 = _mm256_set1_pd(k->b[3]), b4 = _mm256_set1_pd(k->b[4]);
+
+	__m256d v1 = _mm256_set_pd(s[3]->v[1], s[2]->v[1], s[1]->v[1], s[0]->v[1]);
+	__m256d v2 = _mm256_set_pd(s[3]->v[2], s[2]->v[2], s[1]->v[2], s[0]->v[2]);
+	__m256d v3 = _mm256_set_pd(s[3]->v[3], s[2]->v[3], s[1]->v[3], s[0]->v[3]);
+	__m256d v4 = _mm256_set_pd(s[3]->v[4], s[2]->v[4], s[1]->v[4], s[0]->v[4]);
+	__m256d sum = _mm256_setzero_pd();
+
+	const float *in0 = in[0], *in1 = in[1], *in2 = in[2], *in3 = in[3];
+
+	for (size_t i = 0; i < n; i++) {
+		__m256d x = _mm256_cvtps_pd(_mm_set_ps(in3[i], in2[i], in1[i], in0[i]));
+		__m256d v0 = _mm256_sub_pd(x, _mm256_mul_pd(a1, v1));
+		v0 = _mm256_sub_pd(v0, _mm256_mul_pd(a2, v2));
+		v0 = _mm256_sub_pd(v0, _mm256_mul_pd(a3, v3));
+		v0 = _mm256_sub_pd(v0, _mm256_mul_pd(a4, v4));
+
+		__m256d y = _mm256_mul_pd(b0, v0);
+		y = _mm256_add_pd(y, _mm256_mul_pd(b1, v1));
+		y = _mm256_add_pd(y, _mm256_mul_pd(b2, v2));
+		y = _mm256_add_pd(y, _mm256_mul_pd(b3, v3));
+		y = _mm256_add_pd(y, _mm256_mul_pd(b4, v4));
+
+		sum = _mm256_add_pd(sum, _mm256_mul_pd(y, y));
+
+		v4 = v3;
+		v3 = v2;
+		v2 = v1;
+		v1 = v0;
+	}
+
+	store_state_avx2(s, 1, v1);
+	store_state_avx2(s, 2, v2);
+	store_state_avx2(s, 3, v3);
+	store_state_avx2(s, 4, v4);
+
+	_mm256_storeu_pd(sums, sum);
+}
+
+#endif
@@ -0,0 +1,213 @@
+/*
+Loudness Dock for OBS Studio
+Copyright (C) 2025 Norihiro Kamae <norihiro@nagater.net>
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#include <math.h>
+#include <float.h>
+#include "kfilter.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+/* Results of `kfilter_compute_coeffs` printed in 17 digits, so that the common rates do not depend on `tan` and
+ * `pow` of the C library of each platform. */
+static const struct {
+	double samplerate;
+	struct kfilter_coeffs k;
+} precomputed[] = {
+	{
+		44100.0,
+		{
+			{1.0, -3.6528247868858164, 5.0110867625282838, -3.0631592490055355, 0.70489871035628704},
+			{1.5308412300503478, -5.7126624552554253, 8.0018803002813943, -4.9891381549979039,
+			 1.1690790799215871},
+		},
+	},
+	{
+		48000.0,
+		{
+			{1.0, -3.68070674801639, 5.0870452479711306, -3.1315463514467305, 0.72520888847787046},
+			{1.5351248595869702, -5.7619459085803211, 8.1169100492525814, -5.0884818111120804,
+			 1.1983928108528501},
+		},
+	},
+};
+
+void kfilter_init_coeffs(struct kfilter_coeffs *k, double samplerate)
+{
+	for (size_t i = 0; i < sizeof(precomputed) / sizeof(*precomputed); i++) {
+		if (precomputed[i].samplerate == samplerate) {
+			*k = precomputed[i].k;
+			return;
+		}
+	}
+
+	kfilter_compute_coeffs(k, samplerate);
+}
+
+void kfilter_compute_coeffs(struct kfilter_coeffs *k, double samplerate)
+{
+	/* High-shelf stage */
+	double f0 = 1681.974450955533;
+	double G = 3.999843853973347;
+	double Q = 0.7071752369554196;
+
+	double K = tan(M_PI * f0 / samplerate);
+	double Vh = pow(10.0, G / 20.0);
+	double Vb = pow(Vh, 0.4996667741545416);
+
+	double pb[3] = {0.0, 0.0, 0.0};
+	double pa[3] = {1.0, 0.0, 0.0};
+	double rb[3] = {1.0, -2.0, 1.0};
+	double ra[3] = {1.0, 0.0, 0.0};
+
+	double a0 = 1.0 + K / Q + K * K;
+	pb[0] = (Vh + Vb * K / Q + K * K) / a0;
+	pb[1] = 2.0 * (K * K - Vh) / a0;
+	pb[2] = (Vh - Vb * K / Q + K * K) / a0;
+	pa[1] = 2.0 * (K * K - 1.0) / a0;
+	pa[2] = (1.0 - K / Q + K * K) / a0;
+
+	/* High-pass stage */
+	f0 = 38.13547087602444;
+	Q = 0.5003270373238773;
+	K = tan(M_PI * f0 / samplerate);
+
+	ra[1] = 2.0 * (K * K - 1.0) / (1.0 + K / Q + K * K);
+	ra[2] = (1.0 - K / Q + K * K) / (1.0 + K / Q + K * K);
+
+	k->b[0] = pb[0];
+	k->b[1] = pb[0] * rb[1] + pb[1] * rb[0];
+	k->b[2] = pb[0] * rb[2] + pb[1] * rb[1] + pb[2] * rb[0];
+	k->b[3] = pb[1] * rb[2] + pb[2] * rb[1];
+	k->b[4] = pb[2] * rb[2];
+
+	k->a[0] = pa[0] * ra[0];
+	k->a[1] = pa[0] * ra[1] + pa[1] * ra[0];
+	k->a[2] = pa[0] * ra[2] + pa[1] * ra[1] + pa[2] * ra[0];
+	k->a[3] = pa[1] * ra[2] + pa[2] * ra[1];
+	k->a[4] = pa[2] * ra[2];
+}
+
+double kfilter_process(const struct kfilter_coeffs *k, struct kfilter_state *s, const float *in, size_t n)
+{
+	const double a1 = k->a[1], a2 = k->a[2], a3 = k->a[3], a4 = k->a[4];
+	const double b0 = k->b[0], b1 = k->b[1], b2 = k->b[2], b3 = k->b[3], b4 = k->b[4];
+	double v1 = s->v[1], v2 = s->v[2], v3 = s->v[3], v4 = s->v[4];
+	double sum = 0.0;
+
+	for (size_t i = 0; i < n; i++) {
+		double v0 = (double)in[i] - a1 * v1 - a2 * v2 - a3 * v3 - a4 * v4;
+		double y = b0 * v0 + b1 * v1 + b2 * v2 + b3 * v3 + b4 * v4;
+		sum += y * y;
+		v4 = v3;
+		v3 = v2;
+		v2 = v1;
+		v1 = v0;
+	}
+
+	s->v[1] = v1;
+	s->v[2] = v2;
+	s->v[3] = v3;
+	s->v[4] = v4;
+
+	return sum;
+}
+
+void kfilter_flush_denormals(struct kfilter_state *s)
+{
+	for (int i = 1; i < 5; i++) {
+		if (fabs(s->v[i]) < DBL_MIN)
+			s->v[i] = 0.0;
+	}
+}
+
+static enum kfilter_kernel current_kernel = KFILTER_KERNEL_SCALAR;
+
+void kfilter_process_channels(const struct kfilter_coeffs *k, struct kfilter_state *const *s, const float *const *in,
+			      uint32_t n_ch, size_t n, double *sums)
+{
+	uint32_t ch = 0;
+
+#ifdef KFILTER_X86
+	if (current_kernel >= KFILTER_KERNEL_AVX2) {
+		for (; ch + 4 <= n_ch; ch += 4)
+			kfilter_process_avx2(k, s + ch, in + ch, n, sums + ch);
+	}
+	if (current_kernel >= KFILTER_KERNEL_SSE2) {
+		for (; ch + 2 <= n_ch; ch += 2)
+			kfilter_process_sse2(k, s + ch, in + ch, n, sums + ch);
+	}
+#endif
+
+	for (; ch < n_ch; ch++)
+		sums[ch] = kfilter_process(k, s[ch], in[ch], n);
+}
+
+bool kfilter_kernel_supported(enum kfilter_kernel kernel)
+{
+	switch (kernel) {
+	case KFILTER_KERNEL_SCALAR:
+		return true;
+#ifdef KFILTER_X86
+	case KFILTER_KERNEL_SSE2:
+		return kfilter_cpu_has_sse2();
+	case KFILTER_KERNEL_AVX2:
+		return kfilter_cpu_has_avx2();
+#endif
+	default:
+		return false;
+	}
+}
+
+void kfilter_set_kernel(enum kfilter_kernel kernel)
+{
+	if (kfilter_kernel_supported(kernel))
+		current_kernel = kernel;
+}
+
+enum kfilter_kernel kfilter_select_kernel(void)
+{
+	if (kfilter_kernel_supported(KFILTER_KERNEL_AVX2))
+		current_kernel = KFILTER_KERNEL_AVX2;
+	else if (kfilter_kernel_supported(KFILTER_KERNEL_SSE2))
+		current_kernel = KFILTER_KERNEL_SSE2;
+	else
+		current_kernel = KFILTER_KERNEL_SCALAR;
+
+	return current_kernel;
+}
+
+enum kfilter_kernel kfilter_get_kernel(void)
+{
+	return current_kernel;
+}
+
+const char *kfilter_kernel_name(enum kfilter_kernel kernel)
+{
+	switch (kernel) {
+	case KFILTER_KERNEL_SCALAR:
+		return "scalar";
+	case KFILTER_KERNEL_SSE2:
+		return "sse2";
+	case KFILTER_KERNEL_AVX2:
+		return "avx2";
+	}
+	return "unknown";
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define KFILTER_X86
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* K-weighting filter of ITU-R BS.1770, the high-shelf and the high-pass stages
+ * combined into one 4th order direct form II filter, same as libebur128. */
+struct kfilter_coeffs
+{
+	double a[5];
+	double b[5];
+};
+
+struct kfilter_state
+{
+	double v[5];
+};
+
+/* Takes the precomputed coefficients for 44.1 and 48 kHz, otherwise computes them. */
+void kfilter_init_coeffs(struct kfilter_coeffs *k, double samplerate);
+void kfilter_compute_coeffs(struct kfilter_coeffs *k, double samplerate);
+
+/* Filters `n` samples of one channel and returns the sum of squares of the filtered signal.
+ * This is the scalar reference of the vectorized kernels. */
+double kfilter_process(const struct kfilter_coeffs *k, struct kfilter_state *s, const float *in, size_t n);
+
+void kfilter_flush_denormals(struct kfilter_state *s);
+
+/* Filters `n_ch` channels at once. Each channel goes to a lane of the selected kernel.
+ * The results are bit-exact to `kfilter_process`. */
+void kfilter_process_channels(const struct kfilter_coeffs *k, struct kfilter_state *const *s, const float *const *in,
+			      uint32_t n_ch, size_t n, double *sums);
+
+enum kfilter_kernel {
+	KFILTER_KERNEL_SCALAR = 0,
+	KFILTER_KERNEL_SSE2,
+	KFILTER_KERNEL_AVX2,
+};
+
+/* Selects the best kernel for the running CPU. Call once at load time.
+ * The true-peak interpolator follows the same selection. */
+enum kfilter_kernel kfilter_select_kernel(void);
+enum kfilter_kernel kfilter_get_kernel(void);
+bool kfilter_kernel_supported(enum kfilter_kernel kernel);
+void kfilter_set_kernel(enum kfilter_kernel kernel);
+const char *kfilter_kernel_name(enum kfilter_kernel kernel);
+
+/* Kernels processing 2 and 4 channels in the lanes, implemented in kfilter-x86.c */
+void kfilter_process_sse2(const struct kfilter_coeffs *k, struct kfilter_state *const *s, const float *const *in,
+			  size_t n, double *sums);
+void kfilter_process_avx2(const struct kfilter_coeffs *k, struct kfilter_state *const *s, const float *const *in,
+			  size_t n, double *sums);
+bool kfilter_cpu_has_sse2(void);
+bool kfilter_cpu_has_avx2(void);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
@@ -17,6 +17,7 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
 */
 
+#include <algorithm>
 #include <obs-module.h>
 #include <QHBoxLayout>
 #include <QVBoxLayout>
@@ -24,22 +25,43 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 #include <QTimer>
 #include <QMainWindow>
 #include <QTabBar>
+#include <QStringList>
 #include <obs-frontend-api.h>
 #include <obs-websocket-api.h>
 #include <util/config-file.h>
+#include <util/platform.h>
 #ifdef ENABLE_PROFILE
 #include <util/profiler.hpp>
 #endif
 #include "plugin-macros.generated.h"
 #include "loudness-dock.hpp"
 #include "config-dialog.hpp"
-#include "meter.hpp"
+#include "loudness-panel.hpp"
+#include "history-graph.hpp"
 #include "utils.hpp"
+#include "history.h"
+#include "alert.h"
 
 #define CFG "LoudnessDock"
 
 #define QT_TO_UTF8(str) str.toUtf8().constData()
 
+/* Vendor events */
+#define EVENT_MIN_INTERVAL_MS 50
+#define EVENT_LEASE_MS 30000
+
+/* The overview follows no single tab. Refreshed at the rate of the blocks. */
+#define OVERVIEW_REFRESH_MS 100
+
+/* Rows of `panel` in the order of `addRow` */
+enum panel_row_e {
+	ROW_MOMENTARY,
+	ROW_SHORT,
+	ROW_INTEGRATED,
+	ROW_RANGE,
+	ROW_PEAK,
+};
+
 extern "C" obs_websocket_vendor ws_vendor;
 extern "C" obs_websocket_vendor ws_vendor_compat;
 
@@ -52,6 +74,12 @@ static loudness_dock_config_s load_config()
 	config_t *pc = obs_frontend_get_profile_config();
 
 	cfg.abbrev_label = config_get_bool(pc, CFG, "abbrev_label");
+	cfg.overview = config_get_bool(pc, CFG, "overview");
+	cfg.graph_minutes = (int)config_get_int(pc, CFG, "graph_minutes");
+	cfg.session_log = config_get_bool(pc, CFG, "session_log");
+	cfg.event_interval_ms = (int)config_get_int(pc, CFG, "event_interval_ms");
+	if (config_has_user_value(pc, CFG, "idle_refresh_ms"))
+		cfg.idle_refresh_ms = std::max(100, std::min((int)config_get_int(pc, CFG, "idle_refresh_ms"), 1000));
 
 	uint32_t n_tabs = config_get_uint(pc, CFG, "n_tabs");
 	if (!n_tabs) {
@@ -70,12 +98,48 @@ static loudness_dock_config_s load_config()
 			snprintf(name, sizeof(name), "tab.%d.track", i);
 			cfg.tabs[i].track = config_get_int(pc, CFG, name);
 
+			snprintf(name, sizeof(name), "tab.%d.source", i);
+			const char *source = config_get_string(pc, CFG, name);
+			cfg.tabs[i].source = source ? source : "";
+
 			snprintf(name, sizeof(name), "tab.%d.trigger", i);
 			cfg.tabs[i].trigger_mode =
 				(loudness_dock_config_s::trigger_mode_e)config_get_int(pc, CFG, name);
+
+			snprintf(name, sizeof(name), "tab.%d.gating", i);
+			cfg.tabs[i].gating_mode =
+				(loudness_dock_config_s::gating_mode_e)config_get_int(pc, CFG, name);
+
+			snprintf(name, sizeof(name), "tab.%d.peak", i);
+			cfg.tabs[i].peak_mode = (loudness_dock_config_s::peak_mode_e)config_get_int(pc, CFG, name);
 		}
 	}
 
+	uint32_t n_alerts = config_get_uint(pc, CFG, "n_alerts");
+	cfg.alerts.resize(n_alerts);
+	for (uint32_t i = 0; i < n_alerts; i++) {
+		char name[32];
+		snprintf(name, sizeof(name), "alert.%d.name", i);
+		const char *str = config_get_string(pc, CFG, name);
+		cfg.alerts[i].name = str ? str : "";
+
+		snprintf(name, sizeof(name), "alert.%d.tab", i);
+		str = config_get_string(pc, CFG, name);
+		cfg.alerts[i].tab = str ? str : "";
+
+		snprintf(name, sizeof(name), "alert.%d.condition", i);
+		cfg.alerts[i].condition = (loudness_dock_config_s::alert_condition_e)config_get_int(pc, CFG, name);
+
+		snprintf(name, sizeof(name), "alert.%d.threshold", i);
+		cfg.alerts[i].threshold = config_get_double(pc, CFG, name);
+
+		snprintf(name, sizeof(name), "alert.%d.tolerance", i);
+		cfg.alerts[i].tolerance = config_get_double(pc, CFG, name);
+
+		snprintf(name, sizeof(name), "alert.%d.duration", i);
+		cfg.alerts[i].duration = config_get_double(pc, CFG, name);
+	}
+
 	uint32_t n_colors = config_get_uint(pc, CFG, "n_colors");
 	if (!n_colors) {
 		n_colors = 3;
@@ -125,6 +189,11 @@ static void save_config(const loudness_dock_config_s &cfg)
 	config_t *pc = obs_frontend_get_profile_config();
 
 	config_set_bool(pc, CFG, "abbrev_label", cfg.abbrev_label);
+	config_set_bool(pc, CFG, "overview", cfg.overview);
+	config_set_int(pc, CFG, "graph_minutes", cfg.graph_minutes);
+	config_set_bool(pc, CFG, "session_log", cfg.session_log);
+	config_set_int(pc, CFG, "event_interval_ms", cfg.event_interval_ms);
+	config_set_int(pc, CFG, "idle_refresh_ms", cfg.idle_refresh_ms);
 
 	config_set_uint(pc, CFG, "n_tabs", cfg.tabs.size());
 	for (uint32_t i = 0; i < cfg.tabs.size(); i++) {
@@ -135,8 +204,39 @@ static void save_config(const loudness_dock_config_s &cfg)
 		snprintf(name, sizeof(name), "tab.%d.track", i);
 		config_set_int(pc, CFG, name, cfg.tabs[i].track);
 
+		snprintf(name, sizeof(name), "tab.%d.source", i);
+		config_set_string(pc, CFG, name, cfg.tabs[i].source.c_str());
+
 		snprintf(name, sizeof(name), "tab.%d.trigger", i);
 		config_set_int(pc, CFG, name, (int)cfg.tabs[i].trigger_mode);
+
+		snprintf(name, sizeof(name), "tab.%d.gating", i);
+		config_set_int(pc, CFG, name, (int)cfg.tabs[i].gating_mode);
+
+		snprintf(name, sizeof(name), "tab.%d.peak", i);
+		config_set_int(pc, CFG, name, (int)cfg.tabs[i].peak_mode);
+	}
+
+	config_set_uint(pc, CFG, "n_alerts", cfg.alerts.size());
+	for (uint32_t i = 0; i < cfg.alerts.size(); i++) {
+		char name[32];
+		snprintf(name, sizeof(name), "alert.%d.name", i);
+		config_set_string(pc, CFG, name, cfg.alerts[i].name.c_str());
+
+		snprintf(name, sizeof(name), "alert.%d.tab", i);
+		config_set_string(pc, CFG, name, cfg.alerts[i].tab.c_str());
+
+		snprintf(name, sizeof(name), "alert.%d.condition", i);
+		config_set_int(pc, CFG, name, (int)cfg.alerts[i].condition);
+
+		snprintf(name, sizeof(name), "alert.%d.threshold", i);
+		config_set_double(pc, CFG, name, cfg.alerts[i].threshold);
+
+		snprintf(name, sizeof(name), "alert.%d.tolerance", i);
+		config_set_double(pc, CFG, name, cfg.alerts[i].tolerance);
+
+		snprintf(name, sizeof(name), "alert.%d.duration", i);
+		config_set_double(pc, CFG, name, cfg.alerts[i].duration);
 	}
 
 	config_set_uint(pc, CFG, "n_colors", cfg.bar_fg_colors.size());
@@ -162,68 +262,141 @@ static void save_config(const loudness_dock_config_s &cfg)
 	config_save_safe(pc, "tmp", nullptr);
 }
 
-static const char *pause_resume_button_text(bool paused)
+static uint32_t loudness_flags_from_config(const loudness_dock_config_s::tab_config &tab)
 {
-	if (paused)
-		return obs_module_text("Button.Resume");
+	uint32_t flags = 0;
+	if (tab.gating_mode == loudness_dock_config_s::gating_histogram)
+		flags |= LOUDNESS_FLAG_HISTOGRAM;
+	flags |= LOUDNESS_FLAG_PEAK((enum loudness_peak_mode)tab.peak_mode);
+	return flags;
+}
+
+/* Identifies the tab across restarts. The flags are checked by the snapshot itself. */
+static std::string snapshot_key_from_config(const loudness_dock_config_s::tab_config &tab)
+{
+	char *profile = obs_frontend_get_current_profile();
+	std::string key = profile ? profile : "";
+	bfree(profile);
+
+	key += '\n';
+	key += tab.name;
+	key += '\n';
+	if (tab.source.size())
+		key += "source=" + tab.source;
 	else
-		return obs_module_text("Button.Pause");
+		key += "track=" + std::to_string(tab.track);
+	return key;
 }
 
-LoudnessDock::LoudnessDock(QWidget *parent) : QFrame(parent)
+static void loudness_destroy_task(void *param)
 {
-	ASSERT_THREAD(OBS_TASK_UI);
+	loudness_destroy(static_cast<loudness_t *>(param));
+}
 
-	for (auto &r : results)
-		r = -HUGE_VAL;
+/* Deleter of the contexts. A websocket thread can release the last table referring to a context. Then the context
+ * is destroyed later by the UI thread, which otherwise owns the snapshot clients and the analyzers. */
+static void loudness_destroy_in_ui(loudness_t *loudness)
+{
+	if (obs_in_task_thread(OBS_TASK_UI))
+		loudness_destroy(loudness);
+	else
+		obs_queue_task(OBS_TASK_UI, loudness_destroy_task, loudness, false);
+}
 
-	QVBoxLayout *mainLayout = new QVBoxLayout();
+static std::shared_ptr<loudness_t> loudness_create_from_config(const loudness_dock_config_s::tab_config &tab)
+{
+	const uint32_t flags = loudness_flags_from_config(tab);
+	loudness_t *loudness;
+	if (tab.source.size())
+		loudness = loudness_create_source(tab.source.c_str(), flags);
+	else
+		loudness = loudness_create(tab.track, flags);
 
-	tabbar = new QTabBar(this);
-	mainLayout->addWidget(tabbar);
+	if (!loudness)
+		return nullptr;
 
-	QGridLayout *topLayout = new QGridLayout();
+	loudness_set_snapshot(loudness, snapshot_key_from_config(tab).c_str());
+	return std::shared_ptr<loudness_t>(loudness, loudness_destroy_in_ui);
+}
 
-	topLayout->setColumnStretch(3, 1);
+static bool loudness_matches_config(loudness_t *loudness, const loudness_dock_config_s::tab_config &tab)
+{
+	if (!loudness || loudness_flags(loudness) != loudness_flags_from_config(tab))
+		return false;
 
-	int row = 0;
-	auto add_stat = [&](const char *str, QLabel **nameLabel, QLabel **valueLabel, const char *unit,
-			    SingleMeter **meter = nullptr) {
-		*nameLabel = new QLabel(str, this);
-		topLayout->addWidget(*nameLabel, row, 0);
+	const char *source = loudness_source_name(loudness);
+	if (tab.source.size())
+		return source && tab.source == source;
+	return !source && loudness_track(loudness) == tab.track;
+}
 
-		if (valueLabel) {
-			*valueLabel = new QLabel("-", this);
-			topLayout->addWidget(*valueLabel, row, 1);
-			(*valueLabel)->setAlignment(Qt::AlignRight | Qt::AlignVCenter);
+static void emit_alert_task(void *param)
+{
+	obs_data_t *data = static_cast<obs_data_t *>(param);
+	if (ws_vendor)
+		obs_websocket_vendor_emit_event(ws_vendor, "alert", data);
+	obs_data_release(data);
+}
 
-			QFontMetrics metrics((*valueLabel)->font());
-			QRect bounds = metrics.boundingRect(QStringLiteral("%1").arg(-199.0, 2, 'f', 1));
-			(*valueLabel)->setMinimumWidth(bounds.width());
+/* Called with the analyzer locked by the analysis thread, and by the UI thread when the rules are replaced,
+ * disarmed, or paused. The event is emitted by a task of the UI thread after the lock is released. */
+static void alert_event_cb(void *, const struct alert_event *event)
+{
+	if (!ws_vendor)
+		return;
 
-			auto *unitLabel = new QLabel(QString(unit));
-			topLayout->addWidget(unitLabel, row, 2);
-			unitLabel->setMinimumWidth(bounds.width());
-		}
+	obs_data_t *data = obs_data_create();
+	obs_data_set_string(data, "name", event->tab);
+	obs_data_set_string(data, "rule", event->rule);
+	obs_data_set_string(data, "condition", alert_condition_name(event->condition));
+	obs_data_set_bool(data, "active", event->active);
+	obs_data_set_double(data, "value", event->value);
+	obs_data_set_double(data, "threshold", event->threshold);
+	obs_queue_task(OBS_TASK_UI, emit_alert_task, data, false);
+}
 
-		if (meter) {
-			*meter = new SingleMeter(this);
-			topLayout->addWidget(*meter, row, 3);
-		}
+static const char *pause_resume_button_text(bool paused)
+{
+	if (paused)
+		return obs_module_text("Button.Resume");
+	else
+		return obs_module_text("Button.Pause");
+}
+
+LoudnessDock::LoudnessDock(QWidget *parent) : QFrame(parent)
+{
+	ASSERT_THREAD(OBS_TASK_UI);
 
-		row++;
-	};
+	QVBoxLayout *mainLayout = new QVBoxLayout();
 
-	add_stat(obs_module_text("Label.Momentary"), &label_momentary, &r128_momentary, "LUFS", &meter_momentary);
-	add_stat(obs_module_text("Label.Short"), &label_short, &r128_short, "LUFS", &meter_short);
-	add_stat(obs_module_text("Label.Integrated"), &label_integrated, &r128_integrated, "LUFS", &meter_integrated);
-	add_stat(obs_module_text("Label.Range"), &label_range, &r128_range, "LU");
-	add_stat(obs_module_text("Label.Peak"), &label_peak, &r128_peak, "dB<sub>TP</sub>");
+	tabbar = new QTabBar(this);
+	mainLayout->addWidget(tabbar);
 
-	r128_momentary->setObjectName("r128_momentary");
-	r128_short->setObjectName("r128_short");
-	r128_integrated->setObjectName("r128_integrated");
-	r128_peak->setObjectName("r128_peak");
+	panel = new LoudnessPanel(this);
+	panel->setObjectName("loudnessPanel");
+	panel->addRow(obs_module_text("Label.Momentary"), "LUFS", true);
+	panel->addRow(obs_module_text("Label.Short"), "LUFS", true);
+	panel->addRow(obs_module_text("Label.Integrated"), "LUFS", true);
+	panel->addRow(obs_module_text("Label.Range"), "LU", false);
+	panel->addRow(obs_module_text("Label.Peak"), "dB", false);
+	/* The names of the labels that the dock had before, for the themes */
+	panel->setValueObjectName(ROW_MOMENTARY, "r128_momentary");
+	panel->setValueObjectName(ROW_SHORT, "r128_short");
+	panel->setValueObjectName(ROW_INTEGRATED, "r128_integrated");
+	panel->setValueObjectName(ROW_PEAK, "r128_peak");
+	mainLayout->addWidget(panel);
+
+	overview_panel = new LoudnessPanel(this);
+	overview_panel->setObjectName("loudnessOverview");
+	overview_panel->setColumns({"M", "S", "I"});
+	overview_panel->hide();
+	mainLayout->addWidget(overview_panel);
+
+	graph = new HistoryGraph(this);
+	graph->setObjectName("historyGraph");
+	graph->hide();
+	mainLayout->addWidget(graph);
+	connect(graph, &HistoryGraph::historyRequested, this, &LoudnessDock::load_graph_history);
 
 	QHBoxLayout *buttonLayout = new QHBoxLayout;
 	buttonLayout->addStretch();
@@ -247,10 +420,15 @@ LoudnessDock::LoudnessDock(QWidget *parent) : QFrame(parent)
 	buttonLayout->addWidget(configButton);
 	connect(configButton, &QPushButton::clicked, this, &LoudnessDock::on_config);
 
-	mainLayout->addLayout(topLayout);
 	mainLayout->addLayout(buttonLayout);
 	setLayout(mainLayout);
 
+	event_timer = new QTimer(this);
+	connect(event_timer, &QTimer::timeout, this, &LoudnessDock::emit_loudness_event);
+
+	refresh_timer = new QTimer(this);
+	connect(refresh_timer, &QTimer::timeout, this, &LoudnessDock::on_refresh);
+
 	auto cfg = load_config();
 	apply_move_config(cfg);
 
@@ -258,10 +436,6 @@ LoudnessDock::LoudnessDock(QWidget *parent) : QFrame(parent)
 
 	obs_frontend_add_event_callback(LoudnessDock::on_frontend_event, this);
 
-	QTimer *timer = new QTimer(this);
-	timer->start(24);
-	connect(timer, &QTimer::timeout, this, &LoudnessDock::on_timer);
-
 	/*
 	 * Register an obs-websocket request handler. This assumes `LoudnessDock` is instantiated only once.
 	 */
@@ -269,6 +443,10 @@ LoudnessDock::LoudnessDock(QWidget *parent) : QFrame(parent)
 		obs_websocket_vendor_register_request(ws_vendor, "get_loudness", ws_get_loudness_cb, this);
 		obs_websocket_vendor_register_request(ws_vendor, "reset", ws_reset_cb, this);
 		obs_websocket_vendor_register_request(ws_vendor, "pause", ws_pause_cb, this);
+		obs_websocket_vendor_register_request(ws_vendor, "get_history", ws_get_history_cb, this);
+		obs_websocket_vendor_register_request(ws_vendor, "get_all", ws_get_all_cb, this);
+		obs_websocket_vendor_register_request(ws_vendor, "subscribe", ws_subscribe_cb, this);
+		obs_websocket_vendor_register_request(ws_vendor, "unsubscribe", ws_unsubscribe_cb, this);
 	}
 	if (ws_vendor_compat) {
 		obs_websocket_vendor_register_request(ws_vendor_compat, "get_loudness", ws_compat_get_loudness_cb,
@@ -294,10 +472,19 @@ LoudnessDock::~LoudnessDock()
 		obs_websocket_vendor_unregister_request(ws_vendor, "get_loudness");
 		obs_websocket_vendor_unregister_request(ws_vendor, "reset");
 		obs_websocket_vendor_unregister_request(ws_vendor, "pause");
+		obs_websocket_vendor_unregister_request(ws_vendor, "get_history");
+		obs_websocket_vendor_unregister_request(ws_vendor, "get_all");
+		obs_websocket_vendor_unregister_request(ws_vendor, "subscribe");
+		obs_websocket_vendor_unregister_request(ws_vendor, "unsubscribe");
 	}
 
-	for (loudness_t *loudness : ll)
-		loudness_destroy(loudness);
+	if (notify_target)
+		loudness_set_notify(notify_target, nullptr, nullptr);
+
+	/* If a websocket thread still holds the table, the contexts are destroyed by the UI thread after it
+	 * releases the table. */
+	std::atomic_store(&ws_tabs, std::shared_ptr<const tab_table>());
+	ll.clear();
 }
 
 extern "C" QWidget *create_loudness_dock()
@@ -317,7 +504,8 @@ void LoudnessDock::on_reset()
 		return;
 
 	loudness_reset(loudness);
-	update_count = 0;
+	integrated_updated_ns = 0;
+	on_refresh();
 }
 
 void LoudnessDock::on_tabbar_changed(int ix)
@@ -325,11 +513,15 @@ void LoudnessDock::on_tabbar_changed(int ix)
 	ASSERT_THREAD(OBS_TASK_UI);
 
 	ix_ll = ix;
+	publish_tab_table();
 
 	update_pause_button();
+	update_peak_mode();
 
-	update_count = 0;
-	QMetaObject::invokeMethod(this, [this](){ on_timer(); }, Qt::QueuedConnection);
+	integrated_updated_ns = 0;
+	/* Filled from the history of the new tab at the next refresh */
+	graph->clear();
+	update_refresh();
 }
 
 void LoudnessDock::update_pause_button()
@@ -347,6 +539,45 @@ void LoudnessDock::update_pause_button()
 		pauseButton->setText(pause_resume_button_text(paused));
 }
 
+void LoudnessDock::update_peak_mode()
+{
+	ASSERT_THREAD(OBS_TASK_UI);
+
+	loudness_t *loudness = get();
+	if (!loudness)
+		return;
+
+	peak_mode = loudness_peak_mode(loudness);
+
+	const char *unit = "";
+	const char *unit_sub = "";
+	const char *tip = "Config.Peak.Off";
+	switch (peak_mode) {
+	case LOUDNESS_PEAK_TRUE_4X:
+		unit = "dB";
+		unit_sub = "TP";
+		tip = "Config.Peak.True4x";
+		break;
+	case LOUDNESS_PEAK_TRUE_2X:
+		unit = "dB";
+		unit_sub = "TP";
+		tip = "Config.Peak.True2x";
+		break;
+	case LOUDNESS_PEAK_SAMPLE:
+		unit = "dBFS";
+		tip = "Config.Peak.Sample";
+		break;
+	case LOUDNESS_PEAK_OFF:
+		tip = "Config.Peak.Off";
+		break;
+	}
+
+	panel->setUnit(ROW_PEAK, unit, unit_sub);
+	panel->setRowToolTip(ROW_PEAK, obs_module_text(tip));
+	if (peak_mode == LOUDNESS_PEAK_OFF)
+		panel->setValueText(ROW_PEAK, "-");
+}
+
 void LoudnessDock::on_pause(bool pause_)
 {
 	ASSERT_THREAD(OBS_TASK_UI);
@@ -360,7 +591,7 @@ void LoudnessDock::on_pause(bool pause_)
 		pauseButton->setText(pause_resume_button_text(pause_));
 
 	loudness_set_pause(loudness, pause_);
-	update_count = 0;
+	integrated_updated_ns = 0;
 }
 
 void LoudnessDock::on_pause_resume()
@@ -370,57 +601,177 @@ void LoudnessDock::on_pause_resume()
 	on_pause(!paused);
 }
 
-void LoudnessDock::on_timer()
+void LoudnessDock::showEvent(QShowEvent *event)
+{
+	QFrame::showEvent(event);
+
+	/* Follow the window that the dock belongs to, which changes when the dock is floated. */
+	if (watched_window != window()) {
+		if (watched_window)
+			watched_window->removeEventFilter(this);
+		watched_window = window();
+		watched_window->installEventFilter(this);
+	}
+
+	update_refresh();
+}
+
+void LoudnessDock::hideEvent(QHideEvent *event)
+{
+	QFrame::hideEvent(event);
+	update_refresh();
+}
+
+bool LoudnessDock::eventFilter(QObject *obj, QEvent *event)
+{
+	if (obj == watched_window && event->type() == QEvent::WindowStateChange)
+		update_refresh();
+	return QFrame::eventFilter(obj, event);
+}
+
+/* Called by the analysis thread of the current tab. Posts one refresh at a time to the UI thread. */
+void LoudnessDock::on_block_cb(void *param)
+{
+	auto ld = static_cast<LoudnessDock *>(param);
+	if (ld->refresh_pending.exchange(true))
+		return;
+
+	QMetaObject::invokeMethod(
+		ld,
+		[ld]() {
+			ld->refresh_pending = false;
+			ld->on_refresh();
+		},
+		Qt::QueuedConnection);
+}
+
+/* The dock is refreshed by each block of the current tab while it can be seen.
+ * The timer refreshes it only when no block arrives, such as the tab is paused. */
+void LoudnessDock::update_refresh()
+{
+	ASSERT_THREAD(OBS_TASK_UI);
+
+	const bool active = isVisible() && !window()->isMinimized();
+	loudness_t *target = active && !config.overview ? get() : nullptr;
+
+	if (notify_target != target) {
+		if (notify_target)
+			loudness_set_notify(notify_target, nullptr, nullptr);
+		notify_target = target;
+		if (target)
+			loudness_set_notify(target, on_block_cb, this);
+	}
+
+	refresh_active = active;
+	if (!active) {
+		refresh_timer->stop();
+		return;
+	}
+
+	refresh_timer->start(config.overview ? OVERVIEW_REFRESH_MS : config.idle_refresh_ms);
+	QMetaObject::invokeMethod(this, [this]() { on_refresh(); }, Qt::QueuedConnection);
+}
+
+void LoudnessDock::on_refresh()
 {
 #ifdef ENABLE_PROFILE
 	ScopeProfiler profiler(__func__);
 #endif
 	ASSERT_THREAD(OBS_TASK_UI);
 
-	uint32_t flags = LOUDNESS_GET_SHORT;
-
-	loudness_t *loudness = get();
-	if (!loudness)
+	/* Not visible, or a refresh queued before the dock was hidden */
+	if (!refresh_active)
 		return;
 
-	if (update_count % 2 == 0)
-		flags |= LOUDNESS_GET_LONG;
+	if (config.overview) {
+		refresh_overview();
+		return;
+	}
 
-	if (update_count >= 15)
-		update_count = 0;
-	else
-		update_count++;
+	loudness_t *loudness = notify_target;
+	if (!loudness)
+		return;
 
-	std::unique_lock<std::mutex> lock(results_mutex);
+	/* Restarted so that the timer fires only while no block arrives. */
+	refresh_timer->start(config.idle_refresh_ms);
 
-	loudness_get(loudness, results, flags);
+	double results[5];
+	loudness_get(loudness, results, LOUDNESS_GET_SHORT | LOUDNESS_GET_LONG);
 
 	for (auto &r : results) {
 		if (r < -192.0)
 			r = -HUGE_VAL;
 	}
 
-	lock.unlock();
+	/* TECH 3341 requires to update the short-term loudness at least 10 Hz, same as the blocks. */
+	panel->setValue(ROW_MOMENTARY, results[0]);
+	panel->setValue(ROW_SHORT, results[1]);
+	panel->setLevel(ROW_MOMENTARY, results[0]);
+	panel->setLevel(ROW_SHORT, results[1]);
+
+	/* TECH 3341 requires to update at least 1 Hz. */
+	const uint64_t now = os_gettime_ns();
+	if (now - integrated_updated_ns >= 1000000000ULL) {
+		panel->setValue(ROW_INTEGRATED, results[2]);
+		integrated_updated_ns = now;
+	}
+	panel->setValue(ROW_RANGE, results[3]);
+	if (peak_mode != LOUDNESS_PEAK_OFF)
+		panel->setValue(ROW_PEAK, results[4]);
+	panel->setLevel(ROW_INTEGRATED, results[2]);
 
-	if (flags & LOUDNESS_GET_SHORT) {
-		if (update_count % 4 == 0) {
-			/* TECH 3341 requires to update the short-term loudness at least 10 Hz. */
-			r128_momentary->setText(QStringLiteral("%1").arg(results[0], 2, 'f', 1));
-			r128_short->setText(QStringLiteral("%1").arg(results[1], 2, 'f', 1));
-		}
+	if (graph->isVisible())
+		graph->addValues(results[0], results[1], results[2]);
+}
 
-		meter_momentary->setLevel(results[0]);
-		meter_short->setLevel(results[1]);
-	}
-	if (flags & LOUDNESS_GET_LONG) {
-		if (update_count % 16 == 1) {
-			/* TECH 3341 requires to update at least 1 Hz. */
-			r128_integrated->setText(QStringLiteral("%1").arg(results[2], 2, 'f', 1));
+/* Fills the graph from the history of the current tab, such as after a tab switch or while the dock was hidden. */
+void LoudnessDock::load_graph_history()
+{
+	ASSERT_THREAD(OBS_TASK_UI);
+
+	loudness_t *loudness = get();
+	if (!loudness || config.graph_minutes <= 0)
+		return;
+
+	const uint64_t now_ms = os_gettime_ns() / 1000000;
+	const uint64_t span_ms = (uint64_t)config.graph_minutes * 60 * 1000;
+	struct history_result result;
+	loudness_query_history(loudness, now_ms > span_ms ? now_ms - span_ms : 0, UINT64_MAX, 1, &result);
+	graph->setHistory(result);
+	history_result_free(&result);
+}
+
+/* Reads the published results of all the tabs in one pass without locking any of them. */
+void LoudnessDock::refresh_overview()
+{
+#ifdef ENABLE_PROFILE
+	ScopeProfiler profiler(__func__);
+#endif
+	ASSERT_THREAD(OBS_TASK_UI);
+
+	/* TECH 3341 requires to update at least 1 Hz. */
+	const uint64_t now = os_gettime_ns();
+	const bool update_integrated = now - integrated_updated_ns >= 1000000000ULL;
+	if (update_integrated)
+		integrated_updated_ns = now;
+
+	const size_t n = std::min(ll.size(), config.tabs.size());
+	for (size_t i = 0; i < n; i++) {
+		if (!ll[i])
+			continue;
+
+		double results[5];
+		loudness_get(ll[i].get(), results, LOUDNESS_GET_SHORT | LOUDNESS_GET_LONG);
+		for (auto &r : results) {
+			if (r < -192.0)
+				r = -HUGE_VAL;
 		}
-		r128_range->setText(QStringLiteral("%1").arg(results[3], 2, 'f', 1));
-		r128_peak->setText(QStringLiteral("%1").arg(results[4], 2, 'f', 1));
 
-		meter_integrated->setLevel(results[2]);
+		overview_panel->setValue((int)i, results[0], 0);
+		overview_panel->setValue((int)i, results[1], 1);
+		if (update_integrated)
+			overview_panel->setValue((int)i, results[2], 2);
+		overview_panel->setLevel((int)i, results[1]);
 	}
 }
 
@@ -459,36 +810,38 @@ void LoudnessDock::apply_move_config(loudness_dock_config_s &cfg)
 {
 	ASSERT_THREAD(OBS_TASK_UI);
 
+	/* The context might be destroyed below. */
+	if (notify_target) {
+		loudness_set_notify(notify_target, nullptr, nullptr);
+		notify_target = nullptr;
+	}
+
 	if (config.abbrev_label && !cfg.abbrev_label) {
-		label_momentary->setText(obs_module_text("Label.Momentary"));
-		label_short->setText(obs_module_text("Label.Short"));
-		label_integrated->setText(obs_module_text("Label.Integrated"));
-		label_range->show();
-		label_peak->show();
+		panel->setName(ROW_MOMENTARY, obs_module_text("Label.Momentary"));
+		panel->setName(ROW_SHORT, obs_module_text("Label.Short"));
+		panel->setName(ROW_INTEGRATED, obs_module_text("Label.Integrated"));
+		panel->setName(ROW_RANGE, obs_module_text("Label.Range"));
+		panel->setName(ROW_PEAK, obs_module_text("Label.Peak"));
 	}
 	else if (!config.abbrev_label && cfg.abbrev_label) {
-		label_momentary->setText("M");
-		label_short->setText("S");
-		label_integrated->setText("I");
-		label_range->hide();
-		label_peak->hide();
+		panel->setName(ROW_MOMENTARY, "M");
+		panel->setName(ROW_SHORT, "S");
+		panel->setName(ROW_INTEGRATED, "I");
+		panel->setName(ROW_RANGE, QString());
+		panel->setName(ROW_PEAK, QString());
 	}
 
-	std::unique_lock<std::mutex> lock(results_mutex);
-
 	for (uint32_t i = 0; i < cfg.tabs.size() && (int)cfg.tabs.size() > tabbar->count(); i++) {
 		const auto &tab = cfg.tabs[i];
 		if (i >= cfg.tabs.size() || tab.name != QT_TO_UTF8(tabbar->tabText(i))) {
 			tabbar->insertTab(i, QString::fromStdString(tab.name));
-			ll.insert(ll.begin() + i, loudness_create(tab.track));
+			ll.insert(ll.begin() + i, loudness_create_from_config(tab));
 		}
 	}
 	for (uint32_t i = 0; (int)i < tabbar->count() && (int)cfg.tabs.size() < tabbar->count();) {
 		if (i >= cfg.tabs.size() || cfg.tabs[i].name != QT_TO_UTF8(tabbar->tabText(i))) {
 			tabbar->removeTab(i);
-			loudness_t *l = ll[i];
 			ll.erase(ll.begin() + i);
-			loudness_destroy(l);
 		}
 		else
 			i++;
@@ -507,14 +860,18 @@ void LoudnessDock::apply_move_config(loudness_dock_config_s &cfg)
 				tabbar->setTabText(i, QString::fromStdString(tab.name));
 			}
 
-			if (tab.track != loudness_track(ll[i])) {
-				loudness_t *l = ll[i];
-				ll[i] = loudness_create(tab.track);
-				loudness_destroy(l);
+			if (!loudness_matches_config(ll[i].get(), tab))
+				ll[i] = loudness_create_from_config(tab);
+
+			if (ll[i]) {
+				loudness_set_log(ll[i].get(), cfg.session_log ? tab.name.c_str() : nullptr);
+				set_alerts(ll[i].get(), tab, cfg.alerts);
 			}
 		}
 	}
 
+	update_peak_mode();
+
 	if (cfg.tabs.size() <= 1)
 		tabbar->hide();
 	else
@@ -546,20 +903,75 @@ void LoudnessDock::apply_move_config(loudness_dock_config_s &cfg)
 
 	/* Now, the sizes of bar_thresholds, bar_fg_colors, and bar_bg_colors are consistent. */
 
-	SingleMeter *meters[] = {
-		meter_momentary,
-		meter_short,
-		meter_integrated,
-	};
+	panel->setColors(cfg.bar_thresholds.data(), cfg.bar_fg_colors.data(), cfg.bar_bg_colors.data(),
+			 (uint32_t)cfg.bar_fg_colors.size());
+	overview_panel->setColors(cfg.bar_thresholds.data(), cfg.bar_fg_colors.data(), cfg.bar_bg_colors.data(),
+				  (uint32_t)cfg.bar_fg_colors.size());
 
-	for (SingleMeter *meter : meters) {
-		if (!meter)
-			continue;
-		meter->setColors(cfg.bar_thresholds.data(), cfg.bar_fg_colors.data(), cfg.bar_bg_colors.data(),
-				 (uint32_t)cfg.bar_fg_colors.size());
+	overview_panel->clearRows();
+	if (cfg.overview) {
+		for (const auto &tab : cfg.tabs)
+			overview_panel->addRow(QString::fromStdString(tab.name), "LUFS", true);
+	}
+	panel->setVisible(!cfg.overview);
+	overview_panel->setVisible(cfg.overview);
+
+	graph->setColors(cfg.bar_thresholds.data(), cfg.bar_fg_colors.data(), cfg.bar_bg_colors.data(),
+			 (uint32_t)cfg.bar_fg_colors.size());
+	if (cfg.graph_minutes > 0 && !cfg.overview) {
+		graph->setSpan(cfg.graph_minutes * 60);
+		graph->show();
+	}
+	else {
+		graph->hide();
 	}
 
 	config = std::move(cfg);
+
+	publish_tab_table();
+	update_event_timer();
+	update_refresh();
+}
+
+void LoudnessDock::set_alerts(loudness_t *loudness, const loudness_dock_config_s::tab_config &tab,
+			      const std::vector<loudness_dock_config_s::alert_config> &alerts)
+{
+	ASSERT_THREAD(OBS_TASK_UI);
+
+	std::vector<struct alert_rule> rules;
+	for (const auto &alert : alerts) {
+		if (alert.tab.size() && alert.tab != tab.name)
+			continue;
+
+		struct alert_rule rule = {};
+		rule.name = alert.name.c_str();
+		rule.condition = (enum alert_condition)alert.condition;
+		rule.threshold = alert.threshold;
+		rule.tolerance = alert.tolerance;
+		rule.duration = alert.duration;
+		rules.push_back(rule);
+	}
+
+	/* Same as the trigger to pause and resume the tab */
+	uint32_t state = streaming_recording_state;
+	if (recording_paused)
+		state &= ~loudness_dock_config_s::trigger_recording;
+	loudness_arm_alerts(loudness, tab.trigger_mode == loudness_dock_config_s::trigger_none ||
+					      (tab.trigger_mode & state) != 0);
+
+	loudness_set_alerts(loudness, tab.name.c_str(), rules.data(), rules.size(), alert_event_cb, nullptr);
+}
+
+void LoudnessDock::publish_tab_table()
+{
+	ASSERT_THREAD(OBS_TASK_UI);
+
+	auto tabs = std::make_shared<tab_table>();
+	for (size_t i = 0; i < ll.size() && i < config.tabs.size(); i++)
+		tabs->tabs.push_back({config.tabs[i].name, ll[i], (int)config.tabs[i].trigger_mode});
+	tabs->current = ix_ll;
+
+	std::atomic_store(&ws_tabs, std::shared_ptr<const tab_table>(std::move(tabs)));
 }
 
 template<typename F> void run_functor(void *data)
@@ -576,34 +988,173 @@ template<typename F> void run_in_ui_and_wait(F f)
 		obs_queue_task(OBS_TASK_UI, run_functor<F>, &f, true);
 }
 
-void LoudnessDock::ws_get_loudness_cb(obs_data_t *request, obs_data_t *response, void *priv_data)
-{
-	auto ld = static_cast<LoudnessDock *>(priv_data);
-	run_in_ui_and_wait([ld, request, response]() { ld->ws_get_loudness_cb(request, response); });
-}
-
-static void ws_loudness_set_response(obs_data_t *response, double results[5])
+static void ws_loudness_set_response(obs_data_t *response, double results[5], enum loudness_peak_mode peak_mode)
 {
 	obs_data_set_double(response, "momentary", results[0]);
 	obs_data_set_double(response, "short", results[1]);
 	obs_data_set_double(response, "integrated", results[2]);
 	obs_data_set_double(response, "range", results[3]);
 	obs_data_set_double(response, "peak", results[4]);
+	obs_data_set_string(response, "peak_mode", loudness_peak_mode_name(peak_mode));
 }
 
-void LoudnessDock::ws_get_loudness_cb(obs_data_t *request, obs_data_t *response)
+static void ws_set_stats(obs_data_t *data, const loudness_t *loudness)
 {
-	ASSERT_THREAD(OBS_TASK_UI);
+	struct loudness_stats stats;
+	loudness_get_stats(loudness, &stats);
+	obs_data_set_int(data, "ring_capacity", (long long)stats.ring_capacity);
+	obs_data_set_int(data, "ring_high_water", (long long)stats.ring_high_water);
+	obs_data_set_int(data, "ring_overruns", (long long)stats.ring_overruns);
+	obs_data_set_int(data, "ring_dropped_frames", (long long)stats.ring_dropped_frames);
+}
+
+static loudness_t *ws_find_in_data(const tab_table &tabs, obs_data_t *request)
+{
+	const char *name;
+	if (!obs_data_has_user_value(request, "name") || !(name = obs_data_get_string(request, "name")))
+		return nullptr;
+
+	loudness_t *loudness = tabs.find(name);
+	if (!loudness)
+		blog(LOG_ERROR, "Cannot find tab name '%s'", name);
+	return loudness;
+}
+
+/* Called in the websocket thread. Neither the table nor `loudness_get` waits for the UI thread. */
+void LoudnessDock::ws_get_loudness_cb(obs_data_t *request, obs_data_t *response, void *priv_data)
+{
+#ifdef ENABLE_PROFILE
+	ScopeProfiler profiler(__func__);
+#endif
+	auto ld = static_cast<LoudnessDock *>(priv_data);
+
+	std::shared_ptr<const tab_table> tabs = std::atomic_load(&ld->ws_tabs);
+	if (!tabs)
+		return;
 
-	if (loudness_t *loudness = get_by_name_in_data(request)) {
-		double res[5];
+	double res[5];
+	if (loudness_t *loudness = ws_find_in_data(*tabs, request)) {
 		loudness_get(loudness, res, LOUDNESS_GET_SHORT | LOUDNESS_GET_LONG);
-		ws_loudness_set_response(response, res);
+		ws_loudness_set_response(response, res, loudness_peak_mode(loudness));
+		ws_set_stats(response, loudness);
+		return;
+	}
+
+	loudness_t *loudness = tabs->get_current();
+	if (!loudness)
 		return;
+
+	/* Same as the values shown on the dock */
+	loudness_get(loudness, res, LOUDNESS_GET_SHORT | LOUDNESS_GET_LONG);
+	for (auto &r : res) {
+		if (r < -192.0)
+			r = -HUGE_VAL;
+	}
+	ws_loudness_set_response(response, res, loudness_peak_mode(loudness));
+	ws_set_stats(response, loudness);
+}
+
+/* Fields of `get_all`. The first 5 are in the order of the results of `loudness_get`. */
+static const char *ws_all_fields[] = {
+	"momentary", "short", "integrated", "range", "peak", "paused", "trigger", "source", "ring",
+};
+#define WS_ALL_FIELD(i) (1u << (i))
+#define WS_ALL_FIELD_PAUSED WS_ALL_FIELD(5)
+#define WS_ALL_FIELD_TRIGGER WS_ALL_FIELD(6)
+#define WS_ALL_FIELD_SOURCE WS_ALL_FIELD(7)
+#define WS_ALL_FIELD_RING WS_ALL_FIELD(8)
+#define WS_ALL_FIELDS_SHORT (WS_ALL_FIELD(0) | WS_ALL_FIELD(1))
+#define WS_ALL_FIELDS_LONG (WS_ALL_FIELD(2) | WS_ALL_FIELD(3) | WS_ALL_FIELD(4))
+
+/* `fields` is a comma-separated list of the names above. All the fields if not given. */
+static uint32_t ws_all_fields_from_data(obs_data_t *request)
+{
+	if (!obs_data_has_user_value(request, "fields"))
+		return ~0u;
+
+	uint32_t mask = 0;
+	const QStringList names = QString::fromUtf8(obs_data_get_string(request, "fields")).split(',');
+	for (const QString &name : names) {
+		const QString n = name.trimmed();
+		for (size_t i = 0; i < sizeof(ws_all_fields) / sizeof(*ws_all_fields); i++) {
+			if (n == ws_all_fields[i])
+				mask |= WS_ALL_FIELD(i);
+		}
 	}
+	return mask;
+}
+
+static const char *trigger_mode_name(int trigger_mode)
+{
+	switch (trigger_mode) {
+	case loudness_dock_config_s::trigger_streaming:
+		return "streaming";
+	case loudness_dock_config_s::trigger_recording:
+		return "recording";
+	case loudness_dock_config_s::trigger_both:
+		return "both";
+	default:
+		return "none";
+	}
+}
+
+void LoudnessDock::ws_get_all_cb(obs_data_t *request, obs_data_t *response, void *priv_data)
+{
+#ifdef ENABLE_PROFILE
+	ScopeProfiler profiler(__func__);
+#endif
+	auto ld = static_cast<LoudnessDock *>(priv_data);
+
+	std::shared_ptr<const tab_table> tabs = std::atomic_load(&ld->ws_tabs);
+	if (!tabs)
+		return;
+
+	const uint32_t mask = ws_all_fields_from_data(request);
+	uint32_t flags = 0;
+	if (mask & WS_ALL_FIELDS_SHORT)
+		flags |= LOUDNESS_GET_SHORT;
+	if (mask & WS_ALL_FIELDS_LONG)
+		flags |= LOUDNESS_GET_LONG;
 
-	std::unique_lock<std::mutex> lock(results_mutex);
-	ws_loudness_set_response(response, results);
+	obs_data_set_int(response, "current", tabs->current);
+
+	obs_data_array_t *items = obs_data_array_create();
+	for (const tab_table::tab &tab : tabs->tabs) {
+		obs_data_t *item = obs_data_create();
+		obs_data_set_string(item, "name", tab.name.c_str());
+		if (mask & WS_ALL_FIELD_TRIGGER)
+			obs_data_set_string(item, "trigger", trigger_mode_name(tab.trigger_mode));
+
+		if (loudness_t *loudness = tab.loudness.get()) {
+			if (mask & WS_ALL_FIELD_SOURCE) {
+				if (const char *source = loudness_source_name(loudness))
+					obs_data_set_string(item, "source", source);
+				else
+					obs_data_set_int(item, "track", loudness_track(loudness));
+			}
+			if (mask & WS_ALL_FIELD_PAUSED)
+				obs_data_set_bool(item, "paused", loudness_paused(loudness));
+			if (mask & WS_ALL_FIELD_RING)
+				ws_set_stats(item, loudness);
+
+			if (flags) {
+				double res[5];
+				loudness_get(loudness, res, flags);
+				for (int i = 0; i < 5; i++) {
+					if (mask & WS_ALL_FIELD(i))
+						obs_data_set_double(item, ws_all_fields[i], res[i]);
+				}
+				if (mask & WS_ALL_FIELD(4))
+					obs_data_set_string(item, "peak_mode",
+							    loudness_peak_mode_name(loudness_peak_mode(loudness)));
+			}
+		}
+
+		obs_data_array_push_back(items, item);
+		obs_data_release(item);
+	}
+	obs_data_set_array(response, "tabs", items);
+	obs_data_array_release(items);
 }
 
 void LoudnessDock::ws_reset_cb(obs_data_t *request, obs_data_t *, void *priv_data)
@@ -639,6 +1190,206 @@ void LoudnessDock::ws_pause_cb(obs_data_t *request, obs_data_t *, void *priv_dat
 	});
 }
 
+/* Zero or negative values are relative to `now_ms`. */
+static uint64_t history_time_from_data(obs_data_t *request, const char *name, uint64_t now_ms, uint64_t def)
+{
+	if (!obs_data_has_user_value(request, name))
+		return def;
+
+	long long t = obs_data_get_int(request, name);
+	if (t > 0)
+		return (uint64_t)t;
+	if ((uint64_t)-t > now_ms)
+		return 0;
+	return now_ms - (uint64_t)-t;
+}
+
+/* Packs the values in little-endian int16. */
+static QByteArray history_base64(const int16_t *values, size_t n)
+{
+	QByteArray data((int)(n * 2), 0);
+	for (size_t i = 0; i < n; i++) {
+		const uint16_t v = (uint16_t)values[i];
+		data[(int)(i * 2)] = (char)(v & 0xFF);
+		data[(int)(i * 2 + 1)] = (char)(v >> 8);
+	}
+	return data.toBase64();
+}
+
+void LoudnessDock::ws_get_history_cb(obs_data_t *request, obs_data_t *response, void *priv_data)
+{
+	auto ld = static_cast<LoudnessDock *>(priv_data);
+
+	const uint64_t now_ms = os_gettime_ns() / 1000000;
+	const uint64_t since_ms = history_time_from_data(request, "since", now_ms, 0);
+	const uint64_t until_ms = history_time_from_data(request, "until", now_ms, now_ms + 1);
+	long long decimate = obs_data_has_user_value(request, "decimate") ? obs_data_get_int(request, "decimate") : 1;
+	if (decimate < 1)
+		decimate = 1;
+
+	std::shared_ptr<const tab_table> tabs = std::atomic_load(&ld->ws_tabs);
+	if (!tabs)
+		return;
+
+	loudness_t *loudness = obs_data_has_user_value(request, "name") ? ws_find_in_data(*tabs, request)
+									 : tabs->get_current();
+	if (!loudness)
+		return;
+
+	struct history_result result = {};
+	loudness_query_history(loudness, since_ms, until_ms, (uint32_t)decimate, &result);
+
+	obs_data_set_int(response, "now", (long long)now_ms);
+	obs_data_set_int(response, "interval", result.interval_ms);
+	obs_data_set_string(response, "encoding", "int16le-centi-lu");
+	obs_data_set_int(response, "no_value", HISTORY_NO_VALUE);
+
+	obs_data_array_t *segments = obs_data_array_create();
+	for (size_t i = 0; i < result.n_segments; i++) {
+		const struct history_segment &seg = result.segments[i];
+		obs_data_t *item = obs_data_create();
+		obs_data_set_int(item, "start", (long long)seg.start_ms);
+		obs_data_set_int(item, "count", (long long)seg.count);
+		obs_data_set_string(item, "momentary",
+				    history_base64(result.momentary + seg.offset, seg.count).constData());
+		obs_data_set_string(item, "short", history_base64(result.short_term + seg.offset, seg.count).constData());
+		obs_data_array_push_back(segments, item);
+		obs_data_release(item);
+	}
+	obs_data_set_array(response, "segments", segments);
+	obs_data_array_release(segments);
+
+	history_result_free(&result);
+}
+
+/* Emitted at the fastest of the configured interval and the intervals of the subscriptions */
+void LoudnessDock::update_event_timer()
+{
+	ASSERT_THREAD(OBS_TASK_UI);
+
+	const uint64_t now = os_gettime_ns();
+	int interval_ms = config.event_interval_ms;
+	for (auto it = subscriptions.begin(); it != subscriptions.end();) {
+		if (it->expires_ns <= now) {
+			blog(LOG_INFO, "Event subscription '%s' expired", it->id.c_str());
+			it = subscriptions.erase(it);
+			continue;
+		}
+		if (interval_ms <= 0 || it->interval_ms < interval_ms)
+			interval_ms = it->interval_ms;
+		++it;
+	}
+
+	if (interval_ms <= 0 || !ws_vendor) {
+		event_timer->stop();
+		return;
+	}
+
+	if (interval_ms < EVENT_MIN_INTERVAL_MS)
+		interval_ms = EVENT_MIN_INTERVAL_MS;
+	if (!event_timer->isActive() || event_timer->interval() != interval_ms)
+		event_timer->start(interval_ms);
+}
+
+void LoudnessDock::emit_loudness_event()
+{
+#ifdef ENABLE_PROFILE
+	ScopeProfiler profiler(__func__);
+#endif
+	ASSERT_THREAD(OBS_TASK_UI);
+
+	if (subscriptions.size() && subscriptions.front().expires_ns <= os_gettime_ns())
+		update_event_timer();
+
+	/* All the tabs in one event. The values are read without waiting for the analysis threads. */
+	obs_data_t *data = obs_data_create();
+	obs_data_set_int(data, "seq", (long long)++event_seq);
+	obs_data_set_int(data, "now", (long long)(os_gettime_ns() / 1000000));
+	obs_data_set_int(data, "interval_ms", event_timer->interval());
+	obs_data_set_bool(data, "streaming", obs_frontend_streaming_active());
+	obs_data_set_bool(data, "recording", obs_frontend_recording_active());
+	obs_data_set_bool(data, "recording_paused", obs_frontend_recording_paused());
+	obs_data_set_int(data, "current", ix_ll);
+
+	obs_data_array_t *tabs = obs_data_array_create();
+	for (size_t i = 0; i < ll.size() && i < config.tabs.size(); i++) {
+		obs_data_t *item = obs_data_create();
+		obs_data_set_string(item, "name", config.tabs[i].name.c_str());
+		if (ll[i]) {
+			double res[5];
+			loudness_get(ll[i].get(), res, LOUDNESS_GET_SHORT | LOUDNESS_GET_LONG);
+			ws_loudness_set_response(item, res, loudness_peak_mode(ll[i].get()));
+			obs_data_set_bool(item, "paused", loudness_paused(ll[i].get()));
+		}
+		obs_data_array_push_back(tabs, item);
+		obs_data_release(item);
+	}
+	obs_data_set_array(data, "tabs", tabs);
+	obs_data_array_release(tabs);
+
+	obs_websocket_vendor_emit_event(ws_vendor, "loudness", data);
+	obs_data_release(data);
+}
+
+/* obs-websocket broadcasts the vendor events to every client. A subscription keeps the events flowing
+ * at its interval until it expires, so that no event is emitted after the clients have gone. */
+void LoudnessDock::ws_subscribe_cb(obs_data_t *request, obs_data_t *response, void *priv_data)
+{
+	auto ld = static_cast<LoudnessDock *>(priv_data);
+
+	long long interval_ms = obs_data_has_user_value(request, "interval_ms")
+					? obs_data_get_int(request, "interval_ms")
+					: 100;
+	if (interval_ms < EVENT_MIN_INTERVAL_MS)
+		interval_ms = EVENT_MIN_INTERVAL_MS;
+	if (interval_ms > EVENT_LEASE_MS)
+		interval_ms = EVENT_LEASE_MS;
+	const char *id = obs_data_get_string(request, "id");
+
+	/* A subscription with the same id is renewed. */
+	std::string sub_id;
+	run_in_ui_and_wait([&]() {
+		auto &subs = ld->subscriptions;
+		auto it = std::find_if(subs.begin(), subs.end(),
+				       [id](const event_subscription &s) { return id && *id && s.id == id; });
+		if (it == subs.end()) {
+			subs.push_back({});
+			it = subs.end() - 1;
+			it->id = id && *id ? id : "sub-" + std::to_string(++ld->event_subscription_count);
+		}
+		it->interval_ms = (int)interval_ms;
+		it->expires_ns = os_gettime_ns() + EVENT_LEASE_MS * 1000000ULL;
+		sub_id = it->id;
+
+		/* Keep the earliest expiration at the front. */
+		std::sort(subs.begin(), subs.end(), [](const event_subscription &a, const event_subscription &b) {
+			return a.expires_ns < b.expires_ns;
+		});
+
+		ld->update_event_timer();
+	});
+
+	obs_data_set_string(response, "id", sub_id.c_str());
+	obs_data_set_int(response, "interval_ms", interval_ms);
+	obs_data_set_int(response, "expires_in_ms", EVENT_LEASE_MS);
+}
+
+void LoudnessDock::ws_unsubscribe_cb(obs_data_t *request, obs_data_t *, void *priv_data)
+{
+	auto ld = static_cast<LoudnessDock *>(priv_data);
+	const char *id = obs_data_get_string(request, "id");
+
+	run_in_ui_and_wait([&]() {
+		for (auto it = ld->subscriptions.begin(); it != ld->subscriptions.end(); ++it) {
+			if (it->id == id) {
+				ld->subscriptions.erase(it);
+				break;
+			}
+		}
+		ld->update_event_timer();
+	});
+}
+
 void LoudnessDock::ws_compat_get_loudness_cb(obs_data_t *request, obs_data_t *response, void *priv_data)
 {
 	blog(LOG_WARNING, "Vendor 'obs-%s' is deprecated, use '%s' instead.", PLUGIN_NAME, PLUGIN_NAME);
@@ -711,34 +1462,47 @@ void LoudnessDock::on_frontend_event(enum obs_frontend_event event)
 			if (recording_updated && !(trigger_mode & loudness_dock_config_s::trigger_recording))
 				continue;
 
+			loudness_t *loudness = ll[i].get();
+			if (!loudness)
+				continue;
+
+			/* If OBS was restarted during the session, the restored state continues. */
 			if ((trigger_mode & streaming_recording_state) == 0 && (trigger_mode & next_state) != 0) {
-				loudness_reset(ll[i]);
+				if (!loudness_take_restored(loudness))
+					loudness_reset(loudness);
 			}
 
 			auto state_for_pause = next_state;
 			if (recording_paused)
 				state_for_pause &= ~loudness_dock_config_s::trigger_recording;
 
+			loudness_arm_alerts(loudness, (trigger_mode & state_for_pause) != 0);
+
 			if (trigger_mode & state_for_pause) {
-				loudness_set_pause(ll[i], false);
+				loudness_set_pause(loudness, false);
 			}
 			else {
-				bool was_paused = loudness_paused(ll[i]);
-				loudness_set_pause(ll[i], true);
+				bool was_paused = loudness_paused(loudness);
+				loudness_set_pause(loudness, true);
 
 				if (!was_paused) {
 					double res[5];
-					loudness_get(ll[i], res, LOUDNESS_GET_SHORT | LOUDNESS_GET_LONG);
-					blog(LOG_INFO, "name='%s' track=%d M=%0.1f S=%0.1f I=%0.1f R=%0.1f P=%0.1f",
-					     config.tabs[i].name.c_str(), config.tabs[i].track, res[0], res[1], res[2], res[3],
-					     res[4]);
+					loudness_get(loudness, res, LOUDNESS_GET_SHORT | LOUDNESS_GET_LONG);
+					if (config.tabs[i].source.size())
+						blog(LOG_INFO, "name='%s' M=%0.1f S=%0.1f I=%0.1f R=%0.1f P=%0.1f source='%s'",
+						     config.tabs[i].name.c_str(), res[0], res[1], res[2], res[3], res[4],
+						     config.tabs[i].source.c_str());
+					else
+						blog(LOG_INFO, "name='%s' track=%d M=%0.1f S=%0.1f I=%0.1f R=%0.1f P=%0.1f",
+						     config.tabs[i].name.c_str(), config.tabs[i].track, res[0], res[1], res[2],
+						     res[3], res[4]);
 				}
 			}
 			updated = true;
 		}
 
 		if (updated) {
-			update_count = 0;
+			integrated_updated_ns = 0;
 			update_pause_button();
 		}
 		streaming_recording_state = next_state;
@@ -755,11 +1519,9 @@ loudness_t *LoudnessDock::get_by_name(const char *name)
 {
 	ASSERT_THREAD(OBS_TASK_UI);
 
-	std::unique_lock<std::mutex> lock(results_mutex);
-
-	for (size_t i = 0; i < config.tabs.size(); i++) {
+	for (size_t i = 0; i < config.tabs.size() && i < ll.size(); i++) {
 		if (config.tabs[i].name == name)
-			return ll[i];
+			return ll[i].get();
 	}
 
 	blog(LOG_ERROR, "Cannot find tab name '%s'", name);
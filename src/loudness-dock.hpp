@@ -1,13 +1,14 @@
 #pragma once
 #include <QFrame>
 #include <QPushButton>
-#include <QLabel>
 #include <QPointer>
-#include <mutex>
+#include <atomic>
+#include <memory>
 #include <vector>
 #include <obs-frontend-api.h>
 #include "loudness.h"
 #include "config.hpp"
+#include "tab-table.hpp"
 #include "obs.h"
 
 class QTabBar;
@@ -19,68 +20,92 @@ public:
 	LoudnessDock(QWidget *parent = nullptr);
 	~LoudnessDock();
 
+protected:
+	void showEvent(QShowEvent *event) override;
+	void hideEvent(QHideEvent *event) override;
+	bool eventFilter(QObject *obj, QEvent *event) override;
+
 private:
 	QPushButton *pauseButton = nullptr;
 	bool paused = 0;
 
 	QTabBar *tabbar = nullptr;
 
-	QLabel *label_momentary = nullptr;
-	QLabel *label_short = nullptr;
-	QLabel *label_integrated = nullptr;
-	QLabel *label_range = nullptr;
-	QLabel *label_peak = nullptr;
-
-	QLabel *r128_momentary = nullptr;
-	QLabel *r128_short = nullptr;
-	QLabel *r128_integrated = nullptr;
-	QLabel *r128_range = nullptr;
-	QLabel *r128_peak = nullptr;
+	class LoudnessPanel *panel = nullptr;
+	class LoudnessPanel *overview_panel = nullptr;
 
-	class SingleMeter *meter_momentary = nullptr;
-	class SingleMeter *meter_short = nullptr;
-	class SingleMeter *meter_integrated = nullptr;
+	class HistoryGraph *graph = nullptr;
 
 	loudness_dock_config_s config;
 
 	QPointer<class ConfigDialog> dialog;
 
-	std::mutex results_mutex;
-	double results[5];
-
 	bool frontend_exited = false;
 
+	enum loudness_peak_mode peak_mode = LOUDNESS_PEAK_TRUE_4X;
+
 private:
 	/* For EBU R 128 processing
-	 * Written by UI thread only.
-	 * Can be read from other threads.
-	 * UI thread will lock `results_mutex` while writing.
-	 * Other threads need to lock when reading.
+	 * Accessed by UI thread only.
+	 * Other threads read `ws_tabs` instead.
 	 * */
-	std::vector<loudness_t *> ll;
+	std::vector<std::shared_ptr<loudness_t>> ll;
+	std::shared_ptr<const tab_table> ws_tabs;
 	int ix_ll = 0;
-	uint32_t update_count = 0;
+
+	/* Refreshed by the blocks of `notify_target`, or by `refresh_timer` when no block arrives or in the overview */
+	class QTimer *refresh_timer = nullptr;
+	loudness_t *notify_target = nullptr;
+	bool refresh_active = false;
+	std::atomic<bool> refresh_pending{false};
+	QPointer<QWidget> watched_window;
+	uint64_t integrated_updated_ns = 0;
 
 	uint32_t streaming_recording_state = 0;
 	bool recording_paused = false;
 
+	/* Vendor events of obs-websocket */
+	struct event_subscription
+	{
+		std::string id;
+		int interval_ms;
+		uint64_t expires_ns;
+	};
+	std::vector<event_subscription> subscriptions;
+	uint32_t event_subscription_count = 0;
+	class QTimer *event_timer = nullptr;
+	uint64_t event_seq = 0;
+
 private:
 	void on_tabbar_changed(int ix);
 	void update_pause_button();
+	void update_peak_mode();
 	void on_reset();
 	void on_pause(bool pause);
 	void on_pause_resume();
-	void on_timer();
+	void update_refresh();
+	void on_refresh();
+	void refresh_overview();
+	void load_graph_history();
+	static void on_block_cb(void *param);
 	void on_config();
 	void on_config_changed();
 	void on_frontend_event(enum obs_frontend_event event);
 
 	void apply_move_config(loudness_dock_config_s &cfg);
+	void set_alerts(loudness_t *loudness, const loudness_dock_config_s::tab_config &tab,
+			const std::vector<loudness_dock_config_s::alert_config> &alerts);
+	void publish_tab_table();
+	void update_event_timer();
+	void emit_loudness_event();
 
 	static void ws_get_loudness_cb(obs_data_t *, obs_data_t *, void *);
-	void ws_get_loudness_cb(obs_data_t *, obs_data_t *);
 	static void ws_reset_cb(obs_data_t *, obs_data_t *, void *);
 	static void ws_pause_cb(obs_data_t *, obs_data_t *, void *);
+	static void ws_get_history_cb(obs_data_t *, obs_data_t *, void *);
+	static void ws_get_all_cb(obs_data_t *, obs_data_t *, void *);
+	static void ws_subscribe_cb(obs_data_t *, obs_data_t *, void *);
+	static void ws_unsubscribe_cb(obs_data_t *, obs_data_t *, void *);
 
 	static void ws_compat_get_loudness_cb(obs_data_t *, obs_data_t *, void *);
 	static void ws_compat_reset_cb(obs_data_t *, obs_data_t *, void *);
@@ -91,9 +116,9 @@ private:
 	inline loudness_t *get()
 	{
 		if (ix_ll < 0 && ll.size())
-			return ll[0];
+			return ll[0].get();
 		if (0 <= ix_ll && ix_ll < (int)ll.size())
-			return ll[ix_ll];
+			return ll[ix_ll].get();
 		return nullptr;
 	}
 
@@ -0,0 +1,578 @@
+/*
+Loudness Dock for OBS Studio
+Copyright (C) 2025 Norihiro Kamae <norihiro@nagater.net>
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <obs-module.h>
+#include <obs.h>
+#include <vector>
+#include <QFontInfo>
+#include <QFontMetrics>
+#include <QHelpEvent>
+#include <QLabel>
+#include <QPainter>
+#include <QPaintEvent>
+#include <QPixmap>
+#include <QToolTip>
+#ifdef ENABLE_PROFILE
+#include <util/profiler.hpp>
+#endif
+#include "loudness-panel.hpp"
+#include "meter.hpp"
+#include "utils.hpp"
+
+#include "plugin-macros.generated.h"
+
+#define SPACING_H 6
+#define SPACING_V 4
+#define MAX_TEXT 15
+#define MAX_COLUMNS 4
+
+struct panel_glyph
+{
+	QPixmap pixmap;
+	int advance = 0;
+};
+
+/* Printable ASCII characters of one font rendered at `dpr` in `color`. The digits share the widest
+ * advance so that a value keeps the position of each digit. */
+struct panel_glyphs
+{
+	QFont font;
+	int line_height = 0;
+	panel_glyph glyphs[128];
+	qreal dpr = 0.0;
+	QColor color;
+
+	void setFont(const QFont &f)
+	{
+		font = f;
+		QFontMetrics metrics(font);
+		line_height = metrics.height();
+
+		int digit_advance = 0;
+		for (char c = '0'; c <= '9'; c++)
+			digit_advance = std::max(digit_advance, metrics.horizontalAdvance(QChar::fromLatin1(c)));
+		for (int c = 0; c < 128; c++) {
+			if (c < 0x20 || c == 0x7F)
+				glyphs[c].advance = 0;
+			else if ('0' <= c && c <= '9')
+				glyphs[c].advance = digit_advance;
+			else
+				glyphs[c].advance = metrics.horizontalAdvance(QChar::fromLatin1((char)c));
+		}
+		clear();
+	}
+
+	/* The device pixel ratio changes when the window moves to another screen. */
+	void setTarget(qreal new_dpr, const QColor &new_color)
+	{
+		if (dpr == new_dpr && color == new_color)
+			return;
+		clear();
+		dpr = new_dpr;
+		color = new_color;
+	}
+
+	int advance(char c) const { return glyphs[(unsigned char)c & 0x7F].advance; }
+
+	/* Returns the number of the characters and sets their left ends when aligned to the right at `right`. */
+	int layoutText(const char *text, int right, int *xs) const
+	{
+		const int n = (int)strlen(text);
+		for (int i = n - 1; i >= 0; i--) {
+			right -= advance(text[i]);
+			xs[i] = right;
+		}
+		return n;
+	}
+
+	const QPixmap &glyph(char c)
+	{
+		panel_glyph &g = glyphs[(unsigned char)c & 0x7F];
+		if (g.pixmap.isNull() && g.advance > 0) {
+			const int w = std::max((int)(g.advance * dpr), 1);
+			const int h = std::max((int)(line_height * dpr), 1);
+			g.pixmap = QPixmap(w, h);
+			g.pixmap.setDevicePixelRatio(dpr);
+			g.pixmap.fill(Qt::transparent);
+			QPainter painter(&g.pixmap);
+			painter.setPen(color);
+			painter.setFont(font);
+			painter.drawText(QRect(0, 0, g.advance, line_height), Qt::AlignHCenter | Qt::AlignVCenter,
+					 QString(QChar::fromLatin1(c)));
+		}
+		return g.pixmap;
+	}
+
+	void clear()
+	{
+		for (auto &g : glyphs)
+			g.pixmap = QPixmap();
+	}
+};
+
+struct panel_row
+{
+	QString name;
+	QString unit, unit_sub;
+	QString tip;
+	bool has_bar;
+
+	char text[MAX_COLUMNS][MAX_TEXT + 1] = {"-", "-", "-", "-"};
+	float level = -HUGE_VALF;
+	int level_x = 0;
+
+	/* Hidden label giving its font and color to the values, so that the style sheets written for the labels
+	 * that the dock had before still apply. The glyphs of the panel are used if not set. */
+	QLabel *style = nullptr;
+	std::unique_ptr<panel_glyphs> style_glyphs;
+
+	/* Set by `relayout` */
+	QRect rect, name_rect, value_rect[MAX_COLUMNS], unit_rect, bar_rect;
+	int unit_sub_x = 0;
+};
+
+struct loudness_panel_data
+{
+	std::vector<panel_row> rows;
+	MeterBar bar;
+
+	/* The titles are drawn above the values if any. */
+	int n_columns = 1;
+	QStringList titles;
+	QRect title_rect[MAX_COLUMNS];
+
+	QFont font;
+	QFont font_sub;
+	int line_height = 0;
+	int ascent = 0;
+	int sub_offset = 0;
+	QSize content_size;
+	bool in_relayout = false;
+
+	panel_glyphs glyphs;
+
+	panel_glyphs &glyphsOf(const panel_row &r) { return r.style_glyphs ? *r.style_glyphs : glyphs; }
+
+	QRect cellRect(const panel_row &r, int x, char c)
+	{
+		const panel_glyphs &g = glyphsOf(r);
+		return QRect(x, r.value_rect[0].y(), g.advance(c), g.line_height);
+	}
+};
+
+LoudnessPanel::LoudnessPanel(QWidget *parent) : QWidget(parent), data(*new struct loudness_panel_data)
+{
+	ASSERT_THREAD(OBS_TASK_UI);
+
+	data.bar.setFont(font());
+	relayout();
+}
+
+LoudnessPanel::~LoudnessPanel()
+{
+	ASSERT_THREAD(OBS_TASK_UI);
+
+	for (panel_row &r : data.rows)
+		delete r.style;
+	delete &data;
+}
+
+int LoudnessPanel::addRow(const QString &name, const QString &unit, bool bar)
+{
+	ASSERT_THREAD(OBS_TASK_UI);
+
+	panel_row r;
+	r.name = name;
+	r.unit = unit;
+	r.has_bar = bar;
+	data.rows.push_back(std::move(r));
+
+	relayout();
+	return (int)data.rows.size() - 1;
+}
+
+void LoudnessPanel::setName(int row, const QString &name)
+{
+	ASSERT_THREAD(OBS_TASK_UI);
+
+	if (data.rows[row].name == name)
+		return;
+
+	data.rows[row].name = name;
+	relayout();
+}
+
+void LoudnessPanel::setUnit(int row, const QString &unit, const QString &subscript)
+{
+	ASSERT_THREAD(OBS_TASK_UI);
+
+	panel_row &r = data.rows[row];
+	if (r.unit == unit && r.unit_sub == subscript)
+		return;
+
+	r.unit = unit;
+	r.unit_sub = subscript;
+	relayout();
+}
+
+void LoudnessPanel::setValueObjectName(int row, const QString &name)
+{
+	ASSERT_THREAD(OBS_TASK_UI);
+
+	panel_row &r = data.rows[row];
+	delete r.style;
+
+	/* A new label so that the style sheets are applied by the next polish */
+	r.style = new QLabel(this);
+	r.style->setObjectName(name);
+	r.style->hide();
+	r.style->installEventFilter(this);
+	if (!r.style_glyphs)
+		r.style_glyphs.reset(new panel_glyphs);
+
+	relayout();
+}
+
+void LoudnessPanel::setColumns(const QStringList &titles)
+{
+	ASSERT_THREAD(OBS_TASK_UI);
+
+	data.n_columns = std::max(std::min((int)titles.size(), MAX_COLUMNS), 1);
+	data.titles = titles;
+	relayout();
+}
+
+void LoudnessPanel::clearRows()
+{
+	ASSERT_THREAD(OBS_TASK_UI);
+
+	for (panel_row &r : data.rows)
+		delete r.style;
+	data.rows.clear();
+	relayout();
+}
+
+void LoudnessPanel::setRowToolTip(int row, const QString &tip)
+{
+	ASSERT_THREAD(OBS_TASK_UI);
+
+	data.rows[row].tip = tip;
+}
+
+void LoudnessPanel::setValue(int row, double value, int column)
+{
+	char text[MAX_TEXT + 1];
+	snprintf(text, sizeof(text), "%.1f", value);
+	setValueText(row, text, column);
+}
+
+void LoudnessPanel::setValueText(int row, const char *text, int column)
+{
+	ASSERT_THREAD(OBS_TASK_UI);
+
+	panel_row &r = data.rows[row];
+	char *old_text = r.text[column];
+	if (strncmp(old_text, text, MAX_TEXT) == 0)
+		return;
+
+	char new_text[MAX_TEXT + 1];
+	strncpy(new_text, text, MAX_TEXT);
+	new_text[MAX_TEXT] = 0;
+
+	/* Update only the characters that changed or moved. */
+	const panel_glyphs &g = data.glyphsOf(r);
+	const int right = r.value_rect[column].x() + r.value_rect[column].width();
+	int xs_old[MAX_TEXT], xs_new[MAX_TEXT];
+	const int n_old = g.layoutText(old_text, right, xs_old);
+	const int n_new = g.layoutText(new_text, right, xs_new);
+	for (int k = 1; k <= std::max(n_old, n_new); k++) {
+		const int i_old = n_old - k;
+		const int i_new = n_new - k;
+		if (i_old >= 0 && i_new >= 0 && old_text[i_old] == new_text[i_new] && xs_old[i_old] == xs_new[i_new])
+			continue;
+		if (i_old >= 0)
+			update(data.cellRect(r, xs_old[i_old], old_text[i_old]));
+		if (i_new >= 0)
+			update(data.cellRect(r, xs_new[i_new], new_text[i_new]));
+	}
+
+	memcpy(old_text, new_text, sizeof(new_text));
+}
+
+void LoudnessPanel::setLevel(int row, float level)
+{
+	ASSERT_THREAD(OBS_TASK_UI);
+
+	panel_row &r = data.rows[row];
+	r.level = level;
+	if (!r.has_bar)
+		return;
+
+	const int x = data.bar.toX(level, r.bar_rect);
+	if (x == r.level_x)
+		return;
+
+	update(data.bar.levelRect(r.bar_rect, r.level_x, x));
+	r.level_x = x;
+}
+
+void LoudnessPanel::setRange(float min, float max)
+{
+	ASSERT_THREAD(OBS_TASK_UI);
+
+	data.bar.setRange(min, max);
+	updateBars();
+}
+
+void LoudnessPanel::setColors(const float *levels, const uint32_t *fg_colors, const uint32_t *bg_colors,
+			      uint32_t n_colors)
+{
+	ASSERT_THREAD(OBS_TASK_UI);
+
+	data.bar.setColors(levels, fg_colors, bg_colors, n_colors);
+	updateBars();
+}
+
+void LoudnessPanel::updateBars()
+{
+	for (panel_row &r : data.rows) {
+		if (!r.has_bar)
+			continue;
+		r.level_x = data.bar.toX(r.level, r.bar_rect);
+		update(r.bar_rect);
+	}
+}
+
+QSize LoudnessPanel::sizeHint() const
+{
+	return data.content_size;
+}
+
+QSize LoudnessPanel::minimumSizeHint() const
+{
+	return data.content_size;
+}
+
+void LoudnessPanel::relayout()
+{
+	data.in_relayout = true;
+
+	data.font = font();
+	data.font_sub = data.font;
+	data.font_sub.setPointSizeF(QFontInfo(data.font).pointSizeF() * 0.7);
+
+	QFontMetrics metrics(data.font);
+	QFontMetrics metrics_sub(data.font_sub);
+	data.line_height = metrics.height();
+	data.ascent = metrics.ascent();
+	data.sub_offset = metrics_sub.descent();
+
+	data.glyphs.setFont(data.font);
+
+	int xs[MAX_TEXT];
+	data.glyphs.layoutText("-199.0", 0, xs);
+	int value_width = -xs[0];
+
+	int name_width = 0;
+	int unit_width = value_width;
+	for (panel_row &r : data.rows) {
+		if (r.style) {
+			r.style->ensurePolished();
+			r.style_glyphs->setFont(r.style->font());
+			r.style_glyphs->layoutText("-199.0", 0, xs);
+			value_width = std::max(value_width, -xs[0]);
+		}
+		name_width = std::max(name_width, metrics.horizontalAdvance(r.name));
+		unit_width = std::max(unit_width,
+				      metrics.horizontalAdvance(r.unit) + metrics_sub.horizontalAdvance(r.unit_sub));
+	}
+
+	const int x_value = name_width ? name_width + SPACING_H : 0;
+	const int x_unit = x_value + (value_width + SPACING_H) * data.n_columns;
+	const int x_bar = x_unit + unit_width + SPACING_H;
+	const int bar_width = std::max(width() - x_bar, 1);
+
+	int y = 0;
+	bool has_titles = false;
+	for (int c = 0; c < data.n_columns; c++) {
+		data.title_rect[c] = QRect(x_value + (value_width + SPACING_H) * c, y, value_width, data.line_height);
+		has_titles |= c < data.titles.size() && !data.titles[c].isEmpty();
+	}
+	if (has_titles)
+		y += data.line_height + SPACING_V;
+
+	/* The rows with a bar share one height since `MeterBar` caches the pixmaps for one size. */
+	int bar_height = data.bar.minimumHeight();
+	for (panel_row &r : data.rows) {
+		if (r.has_bar)
+			bar_height = std::max({bar_height, data.line_height, data.glyphsOf(r).line_height});
+	}
+
+	for (panel_row &r : data.rows) {
+		const int value_height = data.glyphsOf(r).line_height;
+		const int h = r.has_bar ? bar_height : std::max(data.line_height, value_height);
+		const int y_text = y + (h - data.line_height) / 2;
+		const int y_value = y + (h - value_height) / 2;
+
+		r.rect = QRect(0, y, width(), h);
+		r.name_rect = QRect(0, y_text, name_width, data.line_height);
+		for (int c = 0; c < data.n_columns; c++)
+			r.value_rect[c] = QRect(data.title_rect[c].x(), y_value, value_width, value_height);
+		r.unit_rect = QRect(x_unit, y_text, unit_width, data.line_height);
+		r.bar_rect = r.has_bar ? QRect(x_bar, y, bar_width, h) : QRect();
+		r.unit_sub_x = x_unit + metrics.horizontalAdvance(r.unit);
+
+		y += h + SPACING_V;
+	}
+
+	const QSize content_size(x_bar + 64, std::max(y - SPACING_V, 0));
+	if (content_size != data.content_size) {
+		data.content_size = content_size;
+		updateGeometry();
+	}
+
+	updateBars();
+	update();
+
+	data.in_relayout = false;
+}
+
+void LoudnessPanel::resizeEvent(QResizeEvent *event)
+{
+	ASSERT_THREAD(OBS_TASK_UI);
+
+	QWidget::resizeEvent(event);
+	relayout();
+}
+
+void LoudnessPanel::changeEvent(QEvent *event)
+{
+	if (event->type() == QEvent::FontChange) {
+		data.bar.setFont(font());
+		relayout();
+	}
+
+	QWidget::changeEvent(event);
+}
+
+bool LoudnessPanel::eventFilter(QObject *obj, QEvent *event)
+{
+	switch (event->type()) {
+	case QEvent::StyleChange:
+	case QEvent::FontChange:
+	case QEvent::PaletteChange:
+		if (!data.in_relayout && qobject_cast<QLabel *>(obj))
+			relayout();
+		break;
+	default:
+		break;
+	}
+
+	return QWidget::eventFilter(obj, event);
+}
+
+bool LoudnessPanel::event(QEvent *event)
+{
+	if (event->type() == QEvent::ToolTip) {
+		auto *help = static_cast<QHelpEvent *>(event);
+		for (const panel_row &r : data.rows) {
+			const QRect area = r.value_rect[0] | r.unit_rect;
+			if (!r.tip.isEmpty() && area.contains(help->pos())) {
+				QToolTip::showText(help->globalPos(), r.tip, this, area);
+				return true;
+			}
+		}
+		QToolTip::hideText();
+		event->ignore();
+		return true;
+	}
+
+	return QWidget::event(event);
+}
+
+#ifdef ENABLE_PROFILE
+static const char *name_paintEvent = "LoudnessPanel::paintEvent";
+#endif
+
+void LoudnessPanel::paintEvent(QPaintEvent *event)
+{
+#ifdef ENABLE_PROFILE
+	ScopeProfiler profiler(name_paintEvent);
+#endif
+	ASSERT_THREAD(OBS_TASK_UI);
+
+	const qreal dpr = devicePixelRatioF();
+	const QColor color = palette().color(foregroundRole());
+	data.glyphs.setTarget(dpr, color);
+
+	const QRegion &region = event->region();
+	const QRect clip = region.boundingRect();
+
+	QPainter painter(this);
+	painter.setPen(color);
+	painter.setFont(data.font);
+
+	for (int c = 0; c < data.n_columns && c < data.titles.size(); c++) {
+		if (region.intersects(data.title_rect[c]))
+			painter.drawText(data.title_rect[c], Qt::AlignRight | Qt::AlignVCenter, data.titles[c]);
+	}
+
+	for (const panel_row &r : data.rows) {
+		if (!region.intersects(r.rect))
+			continue;
+
+		panel_glyphs &g = data.glyphsOf(r);
+		if (r.style)
+			g.setTarget(dpr, r.style->palette().color(r.style->foregroundRole()));
+
+		if (region.intersects(r.name_rect)) {
+			painter.setFont(data.font);
+			painter.drawText(r.name_rect, Qt::AlignLeft | Qt::AlignVCenter, r.name);
+		}
+
+		for (int c = 0; c < data.n_columns; c++) {
+			const QRect &value_rect = r.value_rect[c];
+			int xs[MAX_TEXT];
+			const char *text = r.text[c];
+			const int n = g.layoutText(text, value_rect.x() + value_rect.width(), xs);
+			for (int i = 0; i < n; i++) {
+				if (region.intersects(data.cellRect(r, xs[i], text[i])))
+					painter.drawPixmap(QPoint(xs[i], value_rect.y()), g.glyph(text[i]));
+			}
+		}
+
+		if (region.intersects(r.unit_rect)) {
+			const int baseline = r.unit_rect.y() + data.ascent;
+			painter.setFont(data.font);
+			painter.drawText(QPoint(r.unit_rect.x(), baseline), r.unit);
+			if (!r.unit_sub.isEmpty()) {
+				painter.setFont(data.font_sub);
+				painter.drawText(QPoint(r.unit_sub_x, baseline + data.sub_offset), r.unit_sub);
+			}
+		}
+
+		if (r.has_bar && region.intersects(r.bar_rect))
+			data.bar.paint(painter, r.bar_rect, r.level_x, clip, dpr, color);
+	}
+}
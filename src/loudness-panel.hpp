@@ -0,0 +1,57 @@
+#pragma once
+#include <stdint.h>
+#include <QStringList>
+#include <QWidget>
+
+/* Names, values, units, and bars of the loudness drawn by one widget.
+ *
+ * Each row has a name, one or more values, a unit, and optionally a bar. The characters of the values are drawn from
+ * pre-rendered glyphs at the positions aligned to the right, and setting a value updates only the
+ * characters that changed. The bars are drawn by `MeterBar` and a new level updates only around the end
+ * of the bar. The layout is computed when the names, the units, the font, or the size changes. */
+class LoudnessPanel : public QWidget {
+	Q_OBJECT
+
+public:
+	LoudnessPanel(QWidget *parent = nullptr);
+	~LoudnessPanel();
+
+	/* Sets the number of the values of each row. The titles are drawn above the values unless all are empty. */
+	void setColumns(const QStringList &titles);
+
+	/* Returns the index of the new row. */
+	int addRow(const QString &name, const QString &unit, bool bar);
+	void clearRows();
+
+	void setName(int row, const QString &name);
+	/* `subscript` is drawn after `unit`, such as "TP" of dB<sub>TP</sub>. */
+	void setUnit(int row, const QString &unit, const QString &subscript = QString());
+	void setRowToolTip(int row, const QString &tip);
+	/* Draws the values of the row in the font and the color that the style sheets give to a hidden `QLabel`
+	 * named `name`, such as "QLabel#r128_momentary { color: red; }". */
+	void setValueObjectName(int row, const QString &name);
+
+	void setValue(int row, double value, int column = 0);
+	/* Shows a text such as "-" instead of a value. Only ASCII. */
+	void setValueText(int row, const char *text, int column = 0);
+	void setLevel(int row, float level);
+
+	void setRange(float min, float max);
+	void setColors(const float *levels, const uint32_t *fg_colors, const uint32_t *bg_colors, uint32_t n_colors);
+
+	QSize sizeHint() const override;
+	QSize minimumSizeHint() const override;
+
+protected:
+	bool event(QEvent *event) override;
+	bool eventFilter(QObject *obj, QEvent *event) override;
+	void paintEvent(QPaintEvent *event) override;
+	void resizeEvent(QResizeEvent *event) override;
+	void changeEvent(QEvent *event) override;
+
+private:
+	void relayout();
+	void updateBars();
+
+	struct loudness_panel_data &data;
+};
@@ -19,68 +19,255 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 
 #include <obs-module.h>
 #include <util/threading.h>
+#include <util/platform.h>
+#include <string.h>
+#include <time.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
 #include "loudness.h"
-#include "ebur128.h"
+#include "analyzer.h"
+#include "gating.h"
+#include "r128.h"
+#include "snapshot.h"
+#include "session-log.h"
+#include "alert.h"
 #include "plugin-macros.generated.h"
 
-typedef DARRAY(float) float_array_t;
+/* Results published by the analysis thread every 100 ms.
+ * Protected by a sequence lock so that readers never block the writer. The results are stored as the bit
+ * patterns of the doubles and accessed by `seq_load` and `seq_store`, so that a torn read is discarded by the
+ * sequence instead of being a data race. */
+struct published_results
+{
+	volatile long seq;
+	uint64_t results[5];
+};
+
+#ifdef _MSC_VER
+static inline void seq_fence(void)
+{
+#if defined(_M_ARM64) || defined(_M_ARM)
+	__dmb(_ARM64_BARRIER_ISH);
+#else
+	/* x86 does not reorder loads with loads nor stores with stores. */
+	_ReadWriteBarrier();
+#endif
+}
+#define seq_fence_acquire seq_fence
+#define seq_fence_release seq_fence
+#define seq_load_bits(p) ((uint64_t)__iso_volatile_load64((const volatile __int64 *)(p)))
+#define seq_store_bits(p, v) __iso_volatile_store64((volatile __int64 *)(p), (__int64)(v))
+#else
+#define seq_fence_acquire() __atomic_thread_fence(__ATOMIC_ACQUIRE)
+#define seq_fence_release() __atomic_thread_fence(__ATOMIC_RELEASE)
+#define seq_load_bits(p) __atomic_load_n((p), __ATOMIC_RELAXED)
+#define seq_store_bits(p, v) __atomic_store_n((p), (v), __ATOMIC_RELAXED)
+#endif
+
+static inline double seq_load(const uint64_t *p)
+{
+	const uint64_t bits = seq_load_bits(p);
+	double v;
+	memcpy(&v, &bits, sizeof(v));
+	return v;
+}
 
+static inline void seq_store(uint64_t *p, double v)
+{
+	uint64_t bits;
+	memcpy(&bits, &v, sizeof(bits));
+	seq_store_bits(p, bits);
+}
+
+/* Accumulator of one tab. The K-weighting and the peak detection are done by the
+ * analyzer shared by the tabs watching the same track. */
 struct loudness
 {
 	int track;
-	ebur128_state *state;
-	pthread_mutex_t mutex;
-	float_array_t buf;
-	bool paused;
+	uint32_t flags;
+
+	analyzer_t *analyzer;
+	struct analyzer_client client;
+	enum loudness_peak_mode peak_mode;
+	enum r128_peak peak_index;
+
+	/* Written by the analysis thread.
+	 * Other threads need to lock the analyzer to access.
+	 * Readers of the results should use `published` instead. */
+	struct r128_history history;
+	gating_t *gating_integrated;
+	gating_t *gating_range;
+	uint32_t n_blocks;
+	float peak;
+	/* Incremented whenever the state above, `paused`, or `alerts_disarmed` changes so that an unchanged state
+	 * is not saved again. */
+	uint64_t generation;
+
+	struct published_results published;
+
+	/* Incremented by `loudness_reset` when the analysis thread was busy. The next holder of the analyzer lock,
+	 * usually the analysis thread before accumulating the next block, resets the state and catches up
+	 * `reset_applied`. Until then, `loudness_get` returns the cleared results. */
+	volatile long reset_requested;
+	volatile long reset_applied;
+
+	/* Written by the UI thread with the analyzer locked. Read without the lock by the websocket thread. */
+	volatile bool paused;
+
+	/* Checkpoint to a file, enabled by `loudness_set_snapshot` */
+	char *snapshot_key;
+	struct snapshot_client snapshot;
+	uint64_t saved_generation; // Used only by the snapshot thread
+	uint64_t journal_size;     // Used only by the snapshot thread
+	bool journal_restart;      // Set by a reset with the analyzer locked
+	uint64_t restored_ns;
+
+	/* Set by `loudness_set_log` with the analyzer locked */
+	session_log_t *log;
+
+	/* Set by `loudness_set_notify` with the analyzer locked */
+	void (*notify_cb)(void *param);
+	void *notify_param;
+
+	/* Set by `loudness_set_alerts` and `loudness_arm_alerts` with the analyzer locked */
+	alert_set_t *alerts;
+	bool alerts_disarmed;
 };
 
-void audio_cb(void *param, size_t mix_idx, struct audio_data *data);
+static void block_cb(void *param, const struct r128_block *block);
 
-static bool init_state(loudness_t *loudness)
+static void add_gating_blocks(loudness_t *loudness)
 {
-	struct obs_audio_info oai;
-	if (!obs_get_audio_info(&oai)) {
-		blog(LOG_ERROR, "obs_get_audio_info failed");
-		return false;
-	}
+	loudness->n_blocks++;
 
-	int mode = EBUR128_MODE_M | EBUR128_MODE_S | EBUR128_MODE_I | EBUR128_MODE_LRA | EBUR128_MODE_TRUE_PEAK;
-	loudness->state = ebur128_init(get_audio_channels(oai.speakers), oai.samples_per_sec, mode);
-	if (!loudness->state) {
-		blog(LOG_ERROR, "Failed to initialize libebur128");
-		return false;
+	/* 400 ms gating blocks overlapping by 75% */
+	if (loudness->n_blocks >= R128_MOMENTARY_BLOCKS)
+		gating_add(loudness->gating_integrated,
+			   r128_history_energy(&loudness->history, R128_MOMENTARY_BLOCKS));
+
+	/* 3 s short-term blocks every 1 s, same as libebur128 */
+	if (loudness->n_blocks >= R128_SHORT_TERM_BLOCKS && (loudness->n_blocks - R128_SHORT_TERM_BLOCKS) % 10 == 0)
+		gating_add(loudness->gating_range, r128_history_energy(&loudness->history, R128_SHORT_TERM_BLOCKS));
+}
+
+static void publish_results(loudness_t *loudness, const double results[5])
+{
+	/* Writers are serialized by the analyzer lock.
+	 * The odd sequence has to be visible before any result, and the results before the even sequence. */
+	os_atomic_inc_long(&loudness->published.seq);
+	seq_fence_release();
+	for (int i = 0; i < 5; i++)
+		seq_store(&loudness->published.results[i], results[i]);
+	seq_fence_release();
+	os_atomic_inc_long(&loudness->published.seq);
+}
+
+static void publish_state(loudness_t *loudness)
+{
+	double results[5] = {-HUGE_VAL, -HUGE_VAL, -HUGE_VAL, 0.0, -HUGE_VAL};
+
+	results[0] = gating_lufs_from_energy(r128_history_energy(&loudness->history, R128_MOMENTARY_BLOCKS));
+	results[1] = gating_lufs_from_energy(r128_history_energy(&loudness->history, R128_SHORT_TERM_BLOCKS));
+	results[2] = gating_integrated(loudness->gating_integrated);
+	results[3] = gating_range(loudness->gating_range);
+	if (loudness->peak_mode != LOUDNESS_PEAK_OFF)
+		results[4] = obs_mul_to_db(loudness->peak);
+
+	publish_results(loudness, results);
+}
+
+static inline bool reset_pending(const loudness_t *loudness)
+{
+	return os_atomic_load_long(&loudness->reset_applied) != os_atomic_load_long(&loudness->reset_requested);
+}
+
+static void init_peak_mode(loudness_t *loudness)
+{
+	uint32_t factor;
+	switch ((loudness->flags & LOUDNESS_FLAG_PEAK_MASK) >> LOUDNESS_FLAG_PEAK_SHIFT) {
+	case LOUDNESS_PEAK_TRUE_2X:
+		factor = 2;
+		break;
+	case LOUDNESS_PEAK_SAMPLE:
+		factor = 1;
+		break;
+	case LOUDNESS_PEAK_OFF:
+		loudness->peak_mode = LOUDNESS_PEAK_OFF;
+		loudness->client.peaks = 0;
+		return;
+	default:
+		factor = 4;
 	}
 
-	return true;
+	/* The factor can be lowered by the sample rate. */
+	loudness->peak_index = r128_peak_for_factor(analyzer_samplerate(loudness->analyzer), factor);
+	loudness->client.peaks = R128_PEAK_BIT(loudness->peak_index);
+	switch (loudness->peak_index) {
+	case R128_PEAK_TRUE_4X:
+		loudness->peak_mode = LOUDNESS_PEAK_TRUE_4X;
+		break;
+	case R128_PEAK_TRUE_2X:
+		loudness->peak_mode = LOUDNESS_PEAK_TRUE_2X;
+		break;
+	case R128_PEAK_SAMPLE:
+		loudness->peak_mode = LOUDNESS_PEAK_SAMPLE;
+		break;
+	}
 }
 
-loudness_t *loudness_create(int track)
+static loudness_t *create_with_analyzer(analyzer_t *analyzer, uint32_t flags)
 {
+	if (!analyzer)
+		return NULL;
+
 	loudness_t *loudness = bzalloc(sizeof(loudness_t));
-	loudness->track = track;
+	loudness->track = analyzer_track(analyzer);
+	loudness->flags = flags;
+	loudness->analyzer = analyzer;
 
-	if (!init_state(loudness)) {
-		bfree(loudness);
-		return NULL;
-	}
+	enum gating_mode gating_mode = (flags & LOUDNESS_FLAG_HISTOGRAM) ? GATING_MODE_HISTOGRAM : GATING_MODE_EXACT;
+	loudness->gating_integrated = gating_create(gating_mode);
+	loudness->gating_range = gating_create(gating_mode);
+
+	init_peak_mode(loudness);
 
-	pthread_mutex_init(&loudness->mutex, NULL);
+	publish_state(loudness);
 
-	obs_add_raw_audio_callback(track, NULL, audio_cb, loudness);
+	loudness->client.block_cb = block_cb;
+	loudness->client.param = loudness;
+	analyzer_add_client(loudness->analyzer, &loudness->client);
 
 	return loudness;
 }
 
+loudness_t *loudness_create(int track, uint32_t flags)
+{
+	return create_with_analyzer(analyzer_get(track), flags);
+}
+
+loudness_t *loudness_create_source(const char *name, uint32_t flags)
+{
+	return create_with_analyzer(analyzer_get_source(name), flags);
+}
+
 void loudness_destroy(loudness_t *loudness)
 {
 	if (!loudness)
 		return;
 
-	obs_remove_raw_audio_callback(loudness->track, audio_cb, loudness);
-	if (loudness->state)
-		ebur128_destroy(&loudness->state);
-	pthread_mutex_destroy(&loudness->mutex);
-	da_free(loudness->buf);
+	if (loudness->snapshot_key) {
+		snapshot_remove_client(&loudness->snapshot);
+		bfree(loudness->snapshot_key);
+	}
+
+	analyzer_remove_client(loudness->analyzer, &loudness->client);
+	session_log_destroy(loudness->log);
+	alert_set_destroy(loudness->alerts);
+	analyzer_release(loudness->analyzer);
+
+	gating_destroy(loudness->gating_integrated);
+	gating_destroy(loudness->gating_range);
 	bfree(loudness);
 }
 
@@ -94,68 +281,102 @@ void loudness_get(loudness_t *loudness, double results[5], uint32_t flags)
 	profile_start(name_loudness_get);
 #endif
 
-	pthread_mutex_lock(&loudness->mutex);
-
-	if (loudness->state && (flags & LOUDNESS_GET_SHORT)) {
-		ebur128_loudness_momentary(loudness->state, &results[0]);
-		ebur128_loudness_shortterm(loudness->state, &results[1]);
+	const struct published_results *p = &loudness->published;
+	double r[5] = {-HUGE_VAL, -HUGE_VAL, -HUGE_VAL, 0.0, -HUGE_VAL};
+	long seq;
+
+	/* Checked before reading the results since `reset_applied` catches up after the cleared results are
+	 * published. */
+	if (!reset_pending(loudness)) {
+		/* The writer holds the odd sequence only while copying 5 values. */
+		do {
+			while ((seq = os_atomic_load_long(&p->seq)) & 1)
+				;
+			/* `os_atomic_load_long` is a plain volatile read on some platforms. */
+			seq_fence_acquire();
+			for (int i = 0; i < 5; i++)
+				r[i] = seq_load(&p->results[i]);
+			seq_fence_acquire();
+		} while (os_atomic_load_long(&p->seq) != seq);
 	}
 
-	if (loudness->state && (flags & LOUDNESS_GET_LONG)) {
-		double peak = 0.0;
-		ebur128_loudness_global(loudness->state, &results[2]);
-		ebur128_loudness_range(loudness->state, &results[3]);
-		for (unsigned int ch = 0; ch < loudness->state->channels; ch++) {
-			double peak_ch;
-			if (ebur128_true_peak(loudness->state, ch, &peak_ch) == 0) {
-				if (peak_ch > peak)
-					peak = peak_ch;
-			}
-		}
-		results[4] = (float)obs_mul_to_db(peak);
+	if (flags & LOUDNESS_GET_SHORT) {
+		results[0] = r[0];
+		results[1] = r[1];
 	}
 
-	pthread_mutex_unlock(&loudness->mutex);
+	if (flags & LOUDNESS_GET_LONG) {
+		results[2] = r[2];
+		results[3] = r[3];
+		results[4] = r[4];
+	}
 
 #ifdef ENABLE_PROFILE
 	profile_end(name_loudness_get);
 #endif
 }
 
-#ifdef ENABLE_PROFILE
-static const char *name_audio_cb = "loudness-audio_cb";
-#endif
+/* Restarts the accumulation in place. Nothing is freed nor allocated;
+ * the storage of the gating blocks is kept for the next session.
+ * Called with the analyzer locked. */
+static void reset_state(loudness_t *loudness)
+{
+	r128_history_reset(&loudness->history);
+	loudness->n_blocks = 0;
+	loudness->peak = 0.0f;
+	gating_reset(loudness->gating_integrated);
+	gating_reset(loudness->gating_range);
+	loudness->generation++;
+	loudness->journal_restart = true;
+
+	/* A reset begins a new session, also in the log. */
+	if (loudness->log)
+		session_log_rotate(loudness->log);
+}
 
-void audio_cb(void *param, size_t mix_idx, struct audio_data *data)
+/* Applies the reset left by `loudness_reset`. Called with the analyzer locked. */
+static void apply_reset(loudness_t *loudness)
 {
-#ifdef ENABLE_PROFILE
-	profile_start(name_audio_cb);
-#endif
+	const long requested = os_atomic_load_long(&loudness->reset_requested);
+	if (requested == loudness->reset_applied)
+		return;
+
+	reset_state(loudness);
+	publish_state(loudness);
+	os_atomic_set_long(&loudness->reset_applied, requested);
+}
 
-	UNUSED_PARAMETER(mix_idx);
+static void block_cb(void *param, const struct r128_block *block)
+{
 	loudness_t *loudness = param;
 
-	pthread_mutex_lock(&loudness->mutex);
+	apply_reset(loudness);
 
-	if (loudness->state) {
-		const size_t nch = loudness->state->channels;
-		da_resize(loudness->buf, nch * data->frames);
+	r128_history_add(&loudness->history, block->energy);
+	add_gating_blocks(loudness);
 
-		float *array = loudness->buf.array;
-		const float **data_in = (const float **)data->data;
-		for (size_t iframe = 0, k = 0; iframe < data->frames; iframe++) {
-			for (size_t ich = 0; ich < nch; ich++)
-				array[k++] = data_in[ich][iframe];
-		}
+	if (loudness->peak_mode != LOUDNESS_PEAK_OFF && block->peak[loudness->peak_index] > loudness->peak)
+		loudness->peak = block->peak[loudness->peak_index];
+	loudness->generation++;
 
-		ebur128_add_frames_float(loudness->state, array, data->frames);
-	}
+	publish_state(loudness);
 
-	pthread_mutex_unlock(&loudness->mutex);
+	if (loudness->notify_cb)
+		loudness->notify_cb(loudness->notify_param);
 
-#ifdef ENABLE_PROFILE
-	profile_end(name_audio_cb);
-#endif
+	if (loudness->log || loudness->alerts) {
+		double results[5];
+		for (int i = 0; i < 5; i++)
+			results[i] = seq_load(&loudness->published.results[i]);
+		if (loudness->log)
+			session_log_push(loudness->log, results);
+		if (loudness->alerts) {
+			double peak = -HUGE_VAL;
+			if (loudness->peak_mode != LOUDNESS_PEAK_OFF)
+				peak = obs_mul_to_db(block->peak[loudness->peak_index]);
+			alert_set_update(loudness->alerts, results, peak);
+		}
+	}
 }
 
 int loudness_track(const loudness_t *loudness)
@@ -163,33 +384,343 @@ int loudness_track(const loudness_t *loudness)
 	return loudness->track;
 }
 
-void loudness_set_pause(loudness_t *loudness, bool paused)
+const char *loudness_source_name(const loudness_t *loudness)
 {
-	if (paused == loudness->paused)
-		return;
+	return analyzer_source_name(loudness->analyzer);
+}
+
+uint32_t loudness_flags(const loudness_t *loudness)
+{
+	return loudness->flags;
+}
 
-	loudness->paused = paused;
+enum loudness_peak_mode loudness_peak_mode(const loudness_t *loudness)
+{
+	return loudness->peak_mode;
+}
 
-	if (paused) {
-		obs_remove_raw_audio_callback(loudness->track, audio_cb, loudness);
+const char *loudness_peak_mode_name(enum loudness_peak_mode mode)
+{
+	switch (mode) {
+	case LOUDNESS_PEAK_TRUE_4X:
+		return "true-peak-4x";
+	case LOUDNESS_PEAK_TRUE_2X:
+		return "true-peak-2x";
+	case LOUDNESS_PEAK_SAMPLE:
+		return "sample-peak";
+	case LOUDNESS_PEAK_OFF:
+		return "off";
 	}
-	else {
-		obs_add_raw_audio_callback(loudness->track, NULL, audio_cb, loudness);
+	return "unknown";
+}
+
+void loudness_set_pause(loudness_t *loudness, bool paused)
+{
+	if (paused == os_atomic_load_bool(&loudness->paused))
+		return;
+
+	analyzer_lock(loudness->analyzer);
+	os_atomic_set_bool(&loudness->paused, paused);
+	loudness->generation++;
+	/* A paused tab does not receive blocks to end its active rules. */
+	if (loudness->alerts && !loudness->alerts_disarmed)
+		alert_set_arm(loudness->alerts, !paused);
+	analyzer_unlock(loudness->analyzer);
+
+	analyzer_set_client_active(loudness->analyzer, &loudness->client, !paused);
+
+	/* A paused tab does not receive blocks. Apply the reset left to the analysis thread now. */
+	if (paused && reset_pending(loudness)) {
+		analyzer_lock(loudness->analyzer);
+		apply_reset(loudness);
+		analyzer_unlock(loudness->analyzer);
 	}
 }
 
 bool loudness_paused(const loudness_t *loudness)
 {
-	return loudness->paused;
+	return os_atomic_load_bool(&loudness->paused);
 }
 
 void loudness_reset(loudness_t *loudness)
 {
-	pthread_mutex_lock(&loudness->mutex);
+	/* The K-weighting filter of the analyzer keeps running. Only the accumulation restarts.
+	 * The request is visible to `loudness_get` at once. If the analysis thread is busy, the reset is left
+	 * to the next holder of the lock so that the caller does not wait, unless the tab is paused and would
+	 * not receive the next block. */
+	os_atomic_inc_long(&loudness->reset_requested);
+
+	if (!analyzer_trylock(loudness->analyzer)) {
+		if (!os_atomic_load_bool(&loudness->paused))
+			return;
+		analyzer_lock(loudness->analyzer);
+	}
+
+	apply_reset(loudness);
+
+	analyzer_unlock(loudness->analyzer);
+}
+
+void loudness_set_log(loudness_t *loudness, const char *name)
+{
+	session_log_t *log = loudness->log;
+	if (log && name && strcmp(session_log_name(log), name) == 0)
+		return;
+	if (!log && !name)
+		return;
+
+	session_log_t *new_log = name ? session_log_create(name) : NULL;
+
+	analyzer_lock(loudness->analyzer);
+	loudness->log = new_log;
+	analyzer_unlock(loudness->analyzer);
+
+	/* Not used by the analysis thread anymore. The file is closed in background. */
+	session_log_destroy(log);
+}
+
+void loudness_set_notify(loudness_t *loudness, void (*cb)(void *param), void *param)
+{
+	analyzer_lock(loudness->analyzer);
+	loudness->notify_cb = cb;
+	loudness->notify_param = param;
+	analyzer_unlock(loudness->analyzer);
+}
+
+void loudness_set_alerts(loudness_t *loudness, const char *tab, const struct alert_rule *rules, size_t n,
+			 alert_cb_t cb, void *param)
+{
+	alert_set_t *alerts = loudness->alerts;
+	if (alerts && alert_set_equals(alerts, tab, rules, n, cb, param))
+		return;
+	if (!alerts && !n)
+		return;
+
+	alert_set_t *new_alerts = n ? alert_set_create(tab, rules, n, cb, param) : NULL;
+	if (new_alerts && (loudness->alerts_disarmed || os_atomic_load_bool(&loudness->paused)))
+		alert_set_arm(new_alerts, false);
+
+	analyzer_lock(loudness->analyzer);
+	loudness->alerts = new_alerts;
+	/* The rules that were active end here. */
+	if (alerts)
+		alert_set_arm(alerts, false);
+	analyzer_unlock(loudness->analyzer);
+
+	alert_set_destroy(alerts);
+}
+
+void loudness_arm_alerts(loudness_t *loudness, bool armed)
+{
+	analyzer_lock(loudness->analyzer);
+	if (loudness->alerts_disarmed == armed)
+		loudness->generation++;
+	loudness->alerts_disarmed = !armed;
+	if (loudness->alerts)
+		alert_set_arm(loudness->alerts, armed && !os_atomic_load_bool(&loudness->paused));
+	analyzer_unlock(loudness->analyzer);
+}
+
+void loudness_query_history(loudness_t *loudness, uint64_t since_ms, uint64_t until_ms, uint32_t decimate,
+			    struct history_result *result)
+{
+	analyzer_query_history(loudness->analyzer, since_ms, until_ms, decimate, result);
+}
+
+void loudness_get_stats(const loudness_t *loudness, struct loudness_stats *stats)
+{
+	analyzer_get_stats(loudness->analyzer, stats);
+}
+
+#define SNAPSHOT_MAGIC 0x4E53444Cu /* "LDSN" */
+#define SNAPSHOT_VERSION 2
+
+#define SNAPSHOT_STATE_PAUSED 1u
+/* The alerts are armed while the trigger of the tab is active. */
+#define SNAPSHOT_STATE_ARMED 2u
+
+/* The tags of the gatings in the journal */
+#define SNAPSHOT_GATING_INTEGRATED 0
+#define SNAPSHOT_GATING_RANGE 1
+
+/* Layout of a snapshot, followed by the key, `struct snapshot_state`, and the two gatings */
+struct snapshot_header
+{
+	uint32_t magic;
+	uint32_t version;
+	int64_t saved_at; // Seconds of `time`; the monotonic clock does not survive a restart.
+	uint32_t flags;
+	uint32_t key_size;
+	uint32_t state;
+	uint32_t reserved;
+	/* Bytes of the journal written up to this snapshot */
+	uint64_t journal_size;
+};
+
+struct snapshot_state
+{
+	uint32_t n_blocks;
+	float peak;
+	struct r128_history history;
+};
 
-	if (loudness->state)
-		ebur128_destroy(&loudness->state);
-	init_state(loudness);
+static bool snapshot_save_cb(void *param, snapshot_buffer_t *buf, struct snapshot_journal *journal)
+{
+	loudness_t *loudness = param;
+
+	analyzer_lock(loudness->analyzer);
+
+	/* The reset is applied here if no block has come since, such as when the audio has stopped. */
+	apply_reset(loudness);
+
+	if (loudness->generation == loudness->saved_generation) {
+		analyzer_unlock(loudness->analyzer);
+		return false;
+	}
+	loudness->saved_generation = loudness->generation;
+
+	/* After a reset or a restore, the journal is written again from the first block. */
+	if (loudness->journal_restart)
+		journal->restart = true;
+	if (journal->restart) {
+		gating_restart_journal(loudness->gating_integrated);
+		gating_restart_journal(loudness->gating_range);
+		loudness->journal_size = 0;
+		loudness->journal_restart = false;
+	}
+
+	const size_t key_size = strlen(loudness->snapshot_key);
+	struct snapshot_header header = {
+		.magic = SNAPSHOT_MAGIC,
+		.version = SNAPSHOT_VERSION,
+		.saved_at = (int64_t)time(NULL),
+		.flags = loudness->flags,
+		.key_size = (uint32_t)key_size,
+		.state = (os_atomic_load_bool(&loudness->paused) ? SNAPSHOT_STATE_PAUSED : 0) |
+			 (loudness->alerts_disarmed ? 0 : SNAPSHOT_STATE_ARMED),
+	};
+	const struct snapshot_state state = {
+		.n_blocks = loudness->n_blocks,
+		.peak = loudness->peak,
+		.history = loudness->history,
+	};
+
+	/* Only copied while the analysis thread waits. The file is written after unlocking. */
+	snapshot_write(buf, &header, sizeof(header));
+	snapshot_write(buf, loudness->snapshot_key, key_size);
+	snapshot_write(buf, &state, sizeof(state));
+	gating_save(loudness->gating_integrated, buf, &journal->data, SNAPSHOT_GATING_INTEGRATED);
+	gating_save(loudness->gating_range, buf, &journal->data, SNAPSHOT_GATING_RANGE);
+
+	analyzer_unlock(loudness->analyzer);
+
+	/* The size is known after the gatings appended to the journal. */
+	loudness->journal_size += journal->data.num;
+	header.journal_size = loudness->journal_size;
+	memcpy(buf->array, &header, sizeof(header));
+	return true;
+}
+
+/* Called with the analyzer locked. `active` is set if the tab was neither paused nor inactive by its trigger. */
+static bool restore_state(loudness_t *loudness, struct snapshot_reader *r, struct snapshot_reader *journal,
+			  bool *active)
+{
+	struct snapshot_header header;
+	if (!snapshot_read_data(r, &header, sizeof(header)))
+		return false;
+	if (header.magic != SNAPSHOT_MAGIC || header.version != SNAPSHOT_VERSION || header.flags != loudness->flags)
+		return false;
+
+	/* The session is over if the checkpoints stopped long ago. */
+	const int64_t age = (int64_t)time(NULL) - header.saved_at;
+	if (age < 0 || age > LOUDNESS_SNAPSHOT_MAX_AGE)
+		return false;
+
+	/* Different keys can share the file name by a hash collision. */
+	const size_t key_size = strlen(loudness->snapshot_key);
+	if (header.key_size != key_size || r->size - r->pos < key_size ||
+	    memcmp(r->data + r->pos, loudness->snapshot_key, key_size) != 0)
+		return false;
+	r->pos += key_size;
+
+	struct snapshot_state state;
+	if (!snapshot_read_data(r, &state, sizeof(state)) || state.history.index >= R128_SHORT_TERM_BLOCKS)
+		return false;
+
+	/* The journal can have blocks appended after the snapshot if OBS stopped before the snapshot was replaced. */
+	if (header.journal_size > journal->size)
+		return false;
+	journal->size = (size_t)header.journal_size;
+
+	if (!gating_load(loudness->gating_integrated, r, journal, SNAPSHOT_GATING_INTEGRATED) ||
+	    !gating_load(loudness->gating_range, r, journal, SNAPSHOT_GATING_RANGE))
+		return false;
+
+	*active = !(header.state & SNAPSHOT_STATE_PAUSED) && (header.state & SNAPSHOT_STATE_ARMED);
+
+	loudness->n_blocks = state.n_blocks;
+	loudness->peak = state.peak;
+	loudness->history = state.history;
+	return true;
+}
+
+bool loudness_set_snapshot(loudness_t *loudness, const char *key)
+{
+	if (loudness->snapshot_key || !key)
+		return false;
+
+	loudness->snapshot_key = bstrdup(key);
+
+	/* Read before locking so that the analysis thread waits only for the copy. */
+	size_t size = 0, journal_size = 0;
+	uint8_t *data = snapshot_read(key, &size);
+	uint8_t *journal_data = data ? snapshot_read_journal(key, &journal_size) : NULL;
+	bool restored = false;
+
+	if (data) {
+		const uint64_t start_ns = os_gettime_ns();
+		struct snapshot_reader r = {.data = data, .size = size};
+		struct snapshot_reader journal = {.data = journal_data, .size = journal_size};
+		bool active = false;
+
+		analyzer_lock(loudness->analyzer);
+		os_atomic_set_long(&loudness->reset_applied, os_atomic_load_long(&loudness->reset_requested));
+		restored = restore_state(loudness, &r, &journal, &active);
+		if (!restored)
+			reset_state(loudness);
+		/* The restored state is already on the file. The journal is written again from the first block
+		 * since it may have blocks beyond the snapshot. */
+		loudness->generation++;
+		loudness->saved_generation = loudness->generation;
+		loudness->journal_restart = true;
+		publish_state(loudness);
+		analyzer_unlock(loudness->analyzer);
+
+		if (restored) {
+			const uint64_t end_ns = os_gettime_ns();
+			/* A session that had ended before the restart is shown but not continued. */
+			if (active)
+				loudness->restored_ns = end_ns;
+			blog(LOG_INFO, "Restored %.1f s of %s measurement in %.2f ms", loudness->n_blocks * 0.1,
+			     active ? "active" : "inactive", (end_ns - start_ns) * 1e-6);
+		}
+		bfree(data);
+		bfree(journal_data);
+	}
+
+	loudness->snapshot.save_cb = snapshot_save_cb;
+	loudness->snapshot.param = loudness;
+	snapshot_add_client(&loudness->snapshot, key);
+
+	return restored;
+}
+
+bool loudness_take_restored(loudness_t *loudness)
+{
+	if (!loudness->restored_ns)
+		return false;
 
-	pthread_mutex_unlock(&loudness->mutex);
+	const uint64_t elapsed_ns = os_gettime_ns() - loudness->restored_ns;
+	loudness->restored_ns = 0;
+	return elapsed_ns <= LOUDNESS_SNAPSHOT_MAX_AGE * 1000000000ULL;
 }
@@ -6,7 +6,34 @@ extern "C" {
 
 typedef struct loudness loudness_t;
 
-loudness_t *loudness_create(int track);
+/** \brief Create a loudness context.
+ *
+ * @param track The mix index to measure.
+ * @param flags Available options are as below.
+ *   - LOUDNESS_FLAG_HISTOGRAM accumulates the integrated loudness and LRA in a histogram of 0.1 LU bins
+ *     instead of keeping every gating block so that the memory does not grow with the session length.
+ *   - LOUDNESS_FLAG_PEAK(mode) selects how the peak is measured. The default is the 4x true peak.
+ */
+#define LOUDNESS_FLAG_HISTOGRAM (1 << 0)
+#define LOUDNESS_FLAG_PEAK_SHIFT 1
+#define LOUDNESS_FLAG_PEAK_MASK (3 << LOUDNESS_FLAG_PEAK_SHIFT)
+#define LOUDNESS_FLAG_PEAK(mode) ((uint32_t)(mode) << LOUDNESS_FLAG_PEAK_SHIFT)
+
+enum loudness_peak_mode {
+	LOUDNESS_PEAK_TRUE_4X = 0,
+	LOUDNESS_PEAK_TRUE_2X = 1,
+	LOUDNESS_PEAK_SAMPLE = 2,
+	LOUDNESS_PEAK_OFF = 3,
+};
+
+loudness_t *loudness_create(int track, uint32_t flags);
+
+/** \brief Create a loudness context measuring a source instead of a mix.
+ *
+ * The source is looked up by the name. If the source does not exist yet, the measurement starts
+ * when a source of the name is created. A muted source is measured as silence.
+ */
+loudness_t *loudness_create_source(const char *name, uint32_t flags);
 void loudness_destroy(loudness_t *);
 
 /** \brief Get the loudness calculation results.
@@ -21,16 +48,120 @@ void loudness_destroy(loudness_t *);
  * @param flags Indicates which data to get. Available options are as below.
  *   - LOUDNESS_GET_SHORT returns momentary and short term loudness.
  *   - LOUDNESS_GET_LONG returns integrated loudness, LRA, peak.
+ *
+ * The values are published by the analysis thread every 100 ms.
+ * This function does not take any lock and can be called from any thread.
  */
 #define LOUDNESS_GET_SHORT (1 << 0)
 #define LOUDNESS_GET_LONG (1 << 1)
 void loudness_get(loudness_t *loudness, double results[5], uint32_t flags);
 
+/* Returns the track, or -1 if measuring a source. */
 int loudness_track(const loudness_t *loudness);
+/* Returns the source name, or NULL if measuring a track. */
+const char *loudness_source_name(const loudness_t *loudness);
+uint32_t loudness_flags(const loudness_t *loudness);
+
+/** \brief Get the peak mode that produces the peak value.
+ *
+ * The oversampling factor is lowered at high sample rates so that the result can differ from the flags.
+ */
+enum loudness_peak_mode loudness_peak_mode(const loudness_t *loudness);
+const char *loudness_peak_mode_name(enum loudness_peak_mode mode);
 void loudness_set_pause(loudness_t *loudness, bool paused);
 bool loudness_paused(const loudness_t *loudness);
+
+/** \brief Restart the integrated loudness, LRA, and peak.
+ *
+ * The state is cleared in place without any allocation.
+ * `loudness_get` returns the cleared results right after this returns.
+ * If the analysis thread is busy, the reset is applied by the analysis thread before the next block,
+ * or by the next checkpoint of `loudness_set_snapshot` if no block comes, so that the caller returns without waiting.
+ */
 void loudness_reset(loudness_t *loudness);
 
+/** \brief Keep the integrated loudness, LRA, and peak across a restart of OBS.
+ *
+ * The state is saved to a file of `key` every few seconds by a background thread.
+ * If the file was saved within `LOUDNESS_SNAPSHOT_MAX_AGE` seconds with the same key and flags,
+ * the state is restored from it first. The key should identify the tab and what it measures.
+ *
+ * @return true if the state was restored.
+ */
+#define LOUDNESS_SNAPSHOT_MAX_AGE (10 * 60)
+bool loudness_set_snapshot(loudness_t *loudness, const char *key);
+
+/** \brief Check whether the state was restored recently.
+ *
+ * Returns true only once, if the state was restored within `LOUDNESS_SNAPSHOT_MAX_AGE` seconds
+ * and the tab was neither paused nor inactive by its trigger when the state was saved.
+ * A trigger that would reset the state uses this to continue the session interrupted by the restart.
+ */
+bool loudness_take_restored(loudness_t *loudness);
+
+/** \brief Write the loudness of every block to a CSV file.
+ *
+ * @param name The name of the tab included in the file name, or NULL to stop logging.
+ *
+ * A new file begins at the first block after `loudness_reset`.
+ * The files are written in background and neither the analysis thread nor the caller waits for the disk.
+ */
+void loudness_set_log(loudness_t *loudness, const char *name);
+
+/** \brief Get notified whenever the results are published.
+ *
+ * `cb` is called by the analysis thread every 100 ms with the analyzer locked. It should return quickly
+ * and must not call the functions of the context other than `loudness_get`. Set NULL to stop.
+ * Once this function returns, the previous callback is not called anymore.
+ */
+void loudness_set_notify(loudness_t *loudness, void (*cb)(void *param), void *param);
+
+/** \brief Set the alert rules evaluated for every block.
+ *
+ * @param tab The name of the tab included in the events.
+ * @param cb Called by the analysis thread, or by the caller of `loudness_set_alerts`, `loudness_arm_alerts`, and
+ *   `loudness_set_pause`, when a rule becomes active or inactive. The callback is called with the analyzer locked
+ *   and should only queue the event.
+ *
+ * The state of the rules is kept if the same rules are set again. See alert.h for the rules.
+ */
+struct alert_rule;
+struct alert_event;
+void loudness_set_alerts(loudness_t *loudness, const char *tab, const struct alert_rule *rules, size_t n,
+			 void (*cb)(void *param, const struct alert_event *event), void *param);
+
+/** \brief Enable or disable the alert rules, following the trigger of the tab.
+ *
+ * Disabling ends the active rules. The rules are also disabled while the tab is paused.
+ */
+void loudness_arm_alerts(loudness_t *loudness, bool armed);
+
+struct loudness_stats
+{
+	size_t ring_capacity;
+	size_t ring_high_water;
+	size_t ring_overruns;
+	size_t ring_dropped_frames;
+};
+
+/** \brief Get the statistics of the ring buffer between the audio thread and the analysis thread.
+ *
+ * The ring belongs to the analyzer of the track so that the tabs watching the same track share the statistics.
+ * `ring_high_water` is the maximum number of frames that was waiting in the ring.
+ * `ring_overruns` counts the audio packets dropped because the ring was full.
+ */
+void loudness_get_stats(const loudness_t *loudness, struct loudness_stats *stats);
+
+/** \brief Get the history of the momentary and the short-term loudness.
+ *
+ * The history belongs to the analyzer so that it is shared by the tabs watching the same track or source
+ * and is not cleared by `loudness_reset`. The times are in milliseconds of `os_gettime_ns`.
+ * See `history_query` for the parameters. The result has to be freed by `history_result_free`.
+ */
+struct history_result;
+void loudness_query_history(loudness_t *loudness, uint64_t since_ms, uint64_t until_ms, uint32_t decimate,
+			    struct history_result *result);
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
@@ -17,21 +17,19 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
 */
 
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
 #include <cmath>
-#include <obs-module.h>
-#include <obs.h>
 #include <vector>
 #include <QFont>
+#include <QFontInfo>
+#include <QFontMetrics>
 #include <QPainter>
-#include <QPaintEvent>
-#ifdef ENABLE_PROFILE
-#include <util/profiler.hpp>
-#endif
+#include <QPixmap>
 #include "meter.hpp"
 #include "utils.hpp"
 
-#include "plugin-macros.generated.h"
-
 struct color_s
 {
 	float level;
@@ -39,75 +37,72 @@ struct color_s
 	QColor color_bg;
 };
 
-struct private_data
+struct meter_bar_data
 {
 	float min = -59.0f;
 	float max = -5.0f;
-	float current = -99;
-
-	int current_int = -1;
 
-	int tick_height;
-	int font_height, font_width;
+	int tick_height = 4;
+	int font_height = 0, font_width = 0;
 
 	QFont font;
 	std::vector<color_s> colors;
 
-	inline int toX(float value, const QRect &widgetRect) const
+	/* The whole bar drawn full in the foreground colors and empty in the background colors, both with the
+	 * ticks and the labels. A paint blits the left of the level from the former and the rest from the latter.
+	 * Rebuilt by the next paint when `dirty` is set or the size, the ratio, or the color changes. */
+	QPixmap pixmap_fg, pixmap_bg;
+	QSize pixmap_size;
+	qreal pixmap_dpr = 0.0;
+	QColor pixmap_color;
+	bool dirty = true;
+
+	inline int toX(float value, int width) const
 	{
 		if (value <= min)
 			value = min;
 		if (value >= max)
 			value = max;
 		float x = (value - min) / (max - min);
-		return (int)((widgetRect.width() - font_width) * x) + font_width / 2;
+		return (int)((width - font_width) * x) + font_width / 2;
 	}
 };
 
-SingleMeter::SingleMeter(QWidget *parent) : QWidget(parent), data(*new struct private_data)
+MeterBar::MeterBar() : data(*new struct meter_bar_data)
 {
-	ASSERT_THREAD(OBS_TASK_UI);
-
 	data.colors.push_back({-23.0, QColor(0, 0, 255), QColor(0, 0, 85)});
 	data.colors.push_back({-14.0, QColor(0, 255, 0), QColor(0, 85, 0)});
 	data.colors.push_back({0.0, QColor(255, 0, 0), QColor(85, 0, 0)});
+}
+
+MeterBar::~MeterBar()
+{
+	delete &data;
+}
 
-	data.font = font();
+void MeterBar::setFont(const QFont &font)
+{
+	data.font = font;
 	QFontInfo info(data.font);
 	data.font.setPointSizeF(info.pointSizeF() * 0.7);
 	data.font.setFixedPitch(true);
 	QFontMetrics metrics(data.font);
-	setMinimumSize(64, 8 + metrics.capHeight());
 	QRect scaleBounds = metrics.boundingRect("-88");
 
 	data.font_height = metrics.capHeight();
 	data.font_width = scaleBounds.width();
-
-	data.tick_height = 4;
-}
-
-SingleMeter::~SingleMeter()
-{
-	ASSERT_THREAD(OBS_TASK_UI);
-
-	delete &data;
+	data.dirty = true;
 }
 
-void SingleMeter::setRange(float min, float max)
+void MeterBar::setRange(float min, float max)
 {
-	ASSERT_THREAD(OBS_TASK_UI);
-
 	data.min = min;
 	data.max = max;
-
-	update();
+	data.dirty = true;
 }
 
-void SingleMeter::setColors(const float *levels, const uint32_t *fg_colors, const uint32_t *bg_colors,
-			    uint32_t n_colors)
+void MeterBar::setColors(const float *levels, const uint32_t *fg_colors, const uint32_t *bg_colors, uint32_t n_colors)
 {
-	ASSERT_THREAD(OBS_TASK_UI);
-
 	data.colors.resize(n_colors);
 
 	for (uint32_t i = 0; i < n_colors; i++) {
@@ -115,92 +110,107 @@ void SingleMeter::setColors(const float *levels, const uint32_t *fg_colors, cons
 		data.colors[i].color_fg = color_from_int(fg_colors[i]);
 		data.colors[i].color_bg = color_from_int(bg_colors[i]);
 	}
-
-	update();
+	data.dirty = true;
 }
 
-void SingleMeter::setLevel(float level)
+void MeterBar::invalidate()
 {
-	ASSERT_THREAD(OBS_TASK_UI);
-
-	data.current = level;
-
-	/* Update only the bar. */
-	QRect widgetRect = rect();
+	data.dirty = true;
+}
 
-	int next_int = data.toX(level, widgetRect);
-	if (next_int == data.current_int)
-		return;
+int MeterBar::minimumHeight() const
+{
+	return 8 + data.font_height;
+}
 
-	int x0 = std::max(std::min(next_int, data.current_int) - 1, 0);
-	int x1 = std::min(std::max(next_int, data.current_int) + 1, widgetRect.width());
-	QRect rect(x0, 0, x1 - x0, widgetRect.height() - data.tick_height - data.font_height + 1);
-	update(rect);
+int MeterBar::toX(float level, const QRect &rect) const
+{
+	return data.toX(level, rect.width());
 }
 
-#ifdef ENABLE_PROFILE
-static const char *name_paintEvent = "SingleMeter::paintEvent";
-#endif
+QRect MeterBar::levelRect(const QRect &rect, int x0, int x1) const
+{
+	const int left = std::max(std::min(x0, x1) - 1, 0);
+	const int right = std::min(std::max(x0, x1) + 1, rect.width());
+	return QRect(rect.x() + left, rect.y(), right - left, rect.height() - data.tick_height - data.font_height + 1);
+}
 
-void SingleMeter::paintEvent(QPaintEvent *event)
+void MeterBar::rebuild(const QSize &size, qreal dpr, const QColor &color)
 {
-#ifdef ENABLE_PROFILE
-	ScopeProfiler profiler(name_paintEvent);
-#endif
-	ASSERT_THREAD(OBS_TASK_UI);
+	const int width = size.width();
+	const int height = size.height();
+	const QSize device_size(std::max((int)(width * dpr), 1), std::max((int)(height * dpr), 1));
 
-	QRect widgetRect = rect();
-	int width = widgetRect.width();
-	int height = widgetRect.height();
+	QFontMetrics metrics(data.font);
+	const int y2 = height - data.font_height;
+	const int y1 = y2 - data.tick_height;
 
-	QPainter painter(this);
+	float tick_step = (data.max - data.min) * data.font_width / width * 1.2;
+	tick_step = std::ceil(tick_step / 10.0) * 10.0;
+	const float tick_start = std::ceil(data.min / tick_step) * tick_step;
+
+	for (int fg = 0; fg < 2; fg++) {
+		QPixmap &pixmap = fg ? data.pixmap_fg : data.pixmap_bg;
+		if (pixmap.size() != device_size)
+			pixmap = QPixmap(device_size);
+		pixmap.setDevicePixelRatio(dpr);
+		pixmap.fill(Qt::transparent);
+
+		QPainter painter(&pixmap);
+
+		int last = data.toX(data.min, width);
+		for (const auto &c : data.colors) {
+			int level_int = data.toX(c.level, width);
+
+			if (last <= level_int) {
+				QRect fill_rect;
+				fill_rect.setTop(0);
+				fill_rect.setBottom(height - data.tick_height - data.font_height);
+				fill_rect.setLeft(last);
+				fill_rect.setRight(level_int);
+				painter.fillRect(fill_rect, fg ? c.color_fg : c.color_bg);
+			}
+
+			last = level_int;
+		}
 
-	data.current_int = data.toX(data.current, widgetRect);
+		if (!(tick_step > 0.0f))
+			continue;
 
-	int last = data.toX(data.min, widgetRect);
-	for (uint32_t ix = 0; ix < data.colors.size(); ix++) {
-		const auto &c = data.colors[ix];
-		int level_int = data.toX(c.level, widgetRect);
+		painter.setPen(color);
+		painter.setFont(data.font);
 
-		QRect fill_rect;
-		fill_rect.setTop(0);
-		fill_rect.setBottom(height - data.tick_height - data.font_height);
+		for (float tick = tick_start; tick <= data.max; tick += tick_step) {
+			int pos = data.toX(tick, width);
 
-		if (last < data.current_int) {
-			fill_rect.setLeft(last);
-			fill_rect.setRight(std::min(data.current_int, level_int));
-			painter.fillRect(fill_rect, c.color_fg);
-		}
+			painter.drawLine(pos, y1, pos, y2);
 
-		if (data.current_int < level_int) {
-			fill_rect.setLeft(std::max(data.current_int, last));
-			fill_rect.setRight(level_int);
-			painter.fillRect(fill_rect, c.color_bg);
+			QString str = QString::number(tick);
+			QRect b = metrics.boundingRect(str);
+			painter.drawText(pos - b.width() / 2, height, str);
 		}
-
-		last = level_int;
 	}
 
-	const int y2 = height - data.font_height;
-	const int y1 = y2 - data.tick_height;
-
-	/* Skip drawing ticks and labels */
-	if (event->region().boundingRect().bottom() <= y1)
-		return;
-
-	painter.setFont(data.font);
-	QFontMetrics metrics(data.font);
-
-	float tick_step = (data.max - data.min) * data.font_width / width * 1.2;
-	tick_step = std::ceil(tick_step / 10.0) * 10.0;
-	float tick_start = std::ceil(data.min / tick_step) * tick_step;
-	for (float tick = tick_start; tick <= data.max; tick += tick_step) {
-		int pos = data.toX(tick, widgetRect);
-
-		painter.drawLine(pos, y1, pos, y2);
+	data.pixmap_size = size;
+	data.pixmap_dpr = dpr;
+	data.pixmap_color = color;
+	data.dirty = false;
+}
 
-		QString str = QString::number(tick);
-		QRect b = metrics.boundingRect(str);
-		painter.drawText(pos - b.width() / 2, height, str);
-	}
+void MeterBar::paint(QPainter &painter, const QRect &rect, int x, const QRect &clip, qreal dpr, const QColor &color)
+{
+	if (data.dirty || data.pixmap_size != rect.size() || data.pixmap_dpr != dpr || data.pixmap_color != color)
+		rebuild(rect.size(), dpr, color);
+
+	auto blit = [&](const QRect &r, const QPixmap &pixmap) {
+		if (r.isEmpty())
+			return;
+		const QRect s = r.translated(-rect.topLeft());
+		const QRectF source(s.x() * dpr, s.y() * dpr, s.width() * dpr, s.height() * dpr);
+		painter.drawPixmap(QRectF(r), pixmap, source);
+	};
+
+	const QRect area = clip & rect;
+	blit(area & QRect(rect.x(), rect.y(), x, rect.height()), data.pixmap_fg);
+	blit(area & QRect(rect.x() + x, rect.y(), rect.width() - x, rect.height()), data.pixmap_bg);
 }
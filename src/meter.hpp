@@ -1,20 +1,44 @@
 #pragma once
-#include <QWidget>
+#include <stdint.h>
+#include <QColor>
+#include <QRect>
 
-class SingleMeter : public QWidget {
-	Q_OBJECT
+class QFont;
+class QPainter;
 
+/* Horizontal bar of a loudness value with a scale below, drawn into a rectangle of a widget.
+ *
+ * The color bands, the ticks, and the labels are drawn once into two offscreen pixmaps, one for the
+ * filled part and one for the empty part, so that a new level only blits the pixels around the end of the bar.
+ * The pixmaps are shared by all the bars of the same size drawn by the same instance. */
+class MeterBar {
 public:
-	SingleMeter(QWidget *parent = nullptr);
-	~SingleMeter();
+	MeterBar();
+	~MeterBar();
+	MeterBar(const MeterBar &) = delete;
+	MeterBar &operator=(const MeterBar &) = delete;
 
+	/* The scale is drawn in a smaller font derived from `font`. */
+	void setFont(const QFont &font);
 	void setRange(float min, float max);
 	void setColors(const float *levels, const uint32_t *fg_colors, const uint32_t *bg_colors, uint32_t n_colors);
-	void setLevel(float level);
 
-protected:
-	void paintEvent(QPaintEvent *event) override;
+	/* Discards the pixmaps, such as when the palette changes. */
+	void invalidate();
+
+	int minimumHeight() const;
+
+	/* Returns the end of the bar in `rect` for `level` relative to the left of `rect`. */
+	int toX(float level, const QRect &rect) const;
+
+	/* Returns the area to update when the end of the bar moves from `x0` to `x1`. */
+	QRect levelRect(const QRect &rect, int x0, int x1) const;
+
+	/* Draws the bar ending at `x` inside `clip`. The ticks and the labels are drawn in `color`. */
+	void paint(QPainter &painter, const QRect &rect, int x, const QRect &clip, qreal dpr, const QColor &color);
 
 private:
-	struct private_data &data;
+	void rebuild(const QSize &size, qreal dpr, const QColor &color);
+
+	struct meter_bar_data &data;
 };
@@ -22,6 +22,10 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 #include <obs-websocket-api.h>
 
 #include "plugin-macros.generated.h"
+#include "kfilter.h"
+#include "alloc-guard.h"
+#include "session-log.h"
+#include "analyzer.h"
 
 OBS_DECLARE_MODULE()
 OBS_MODULE_USE_DEFAULT_LOCALE(PLUGIN_NAME, "en-US")
@@ -44,9 +48,21 @@ const char *obs_module_name(void)
 bool obs_module_load(void)
 {
 	blog(LOG_INFO, "plugin loaded (version %s)", PLUGIN_VERSION);
+	blog(LOG_INFO, "K-weighting kernel: %s", kfilter_kernel_name(kfilter_select_kernel()));
+	analyzer_module_load();
 	return true;
 }
 
+void obs_module_unload(void)
+{
+	analyzer_module_unload();
+	session_log_shutdown();
+
+#ifdef WITH_ASSERT_NO_ALLOC
+	alloc_guard_report();
+#endif
+}
+
 void obs_module_post_load(void)
 {
 	ws_vendor = obs_websocket_register_vendor(PLUGIN_NAME);
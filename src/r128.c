@@ -0,0 +1,245 @@
+/*
+Loudness Dock for OBS Studio
+Copyright (C) 2025 Norihiro Kamae <norihiro@nagater.net>
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#include <obs-module.h>
+#include "r128.h"
+#include "kfilter.h"
+#include "true-peak.h"
+
+/* Interpolators for R128_PEAK_TRUE_2X and R128_PEAK_TRUE_4X */
+#define N_TP 2
+
+struct r128
+{
+	uint32_t channels;
+	uint32_t samplerate;
+	size_t samples_in_100ms;
+	size_t frames_in_block;
+
+	struct kfilter_coeffs kfilter;
+	struct kfilter_state kstate[R128_MAX_CHANNELS];
+	double weight[R128_MAX_CHANNELS];
+
+	/* Channels with non-zero weight, packed for `kfilter_process_channels` */
+	uint32_t n_active;
+	uint32_t active[R128_MAX_CHANNELS];
+	struct kfilter_state *active_kstate[R128_MAX_CHANNELS];
+
+	/* Sum of the weighted squares, not yet divided by the number of frames */
+	double block_sum;
+	float block_peak[R128_N_PEAKS];
+
+	uint32_t peaks;
+	struct true_peak_filter tp_filter[N_TP];
+	struct true_peak_state tp_state[N_TP][R128_MAX_CHANNELS];
+	struct true_peak_state *tp_state_p[N_TP][R128_MAX_CHANNELS];
+};
+
+/* Same as the default channel map of libebur128:
+ * 4 channels (4.0) are L, R, Ls, Rs, 5 channels (4.1) are L, R, C, Ls, Rs,
+ * and the others are L, R, C, (unused), Ls, Rs with the rest unused. */
+static double channel_weight(uint32_t ch, uint32_t channels)
+{
+	if (channels == 4)
+		return ch < 2 ? 1.0 : 1.41;
+	if (channels == 5)
+		return ch < 3 ? 1.0 : 1.41;
+
+	switch (ch) {
+	case 0:
+	case 1:
+	case 2:
+		return 1.0;
+	case 4:
+	case 5:
+		return 1.41;
+	default:
+		return 0.0;
+	}
+}
+
+r128_t *r128_create(uint32_t channels, uint32_t samplerate)
+{
+	if (channels < 1 || channels > R128_MAX_CHANNELS || samplerate < 10) {
+		blog(LOG_ERROR, "r128_create: unsupported audio format: channels=%u samplerate=%u", channels,
+		     samplerate);
+		return NULL;
+	}
+
+	r128_t *r = bzalloc(sizeof(r128_t));
+	r->channels = channels;
+	r->samplerate = samplerate;
+	r->samples_in_100ms = (samplerate + 5) / 10;
+
+	kfilter_init_coeffs(&r->kfilter, (double)samplerate);
+	for (uint32_t ch = 0; ch < channels; ch++) {
+		r->weight[ch] = channel_weight(ch, channels);
+		if (r->weight[ch] > 0.0) {
+			r->active[r->n_active] = ch;
+			r->active_kstate[r->n_active] = &r->kstate[ch];
+			r->n_active++;
+		}
+	}
+
+	true_peak_init_filter(&r->tp_filter[0], 2);
+	true_peak_init_filter(&r->tp_filter[1], 4);
+	for (int i = 0; i < N_TP; i++) {
+		for (uint32_t ch = 0; ch < channels; ch++)
+			r->tp_state_p[i][ch] = &r->tp_state[i][ch];
+	}
+
+	return r;
+}
+
+void r128_destroy(r128_t *r)
+{
+	bfree(r);
+}
+
+void r128_reset(r128_t *r)
+{
+	r->frames_in_block = 0;
+	memset(r->kstate, 0, sizeof(r->kstate));
+	r->block_sum = 0.0;
+	memset(r->block_peak, 0, sizeof(r->block_peak));
+	memset(r->tp_state, 0, sizeof(r->tp_state));
+}
+
+uint32_t r128_channels(const r128_t *r)
+{
+	return r->channels;
+}
+
+uint32_t r128_samplerate(const r128_t *r)
+{
+	return r->samplerate;
+}
+
+enum r128_peak r128_peak_for_factor(uint32_t samplerate, uint32_t factor)
+{
+	const uint32_t max_factor = true_peak_factor_for_rate(samplerate);
+	if (factor > max_factor)
+		factor = max_factor;
+
+	if (factor >= 4)
+		return R128_PEAK_TRUE_4X;
+	if (factor >= 2)
+		return R128_PEAK_TRUE_2X;
+	return R128_PEAK_SAMPLE;
+}
+
+void r128_set_peaks(r128_t *r, uint32_t peaks)
+{
+	for (int i = 0; i < N_TP; i++) {
+		const uint32_t bit = R128_PEAK_BIT(R128_PEAK_TRUE_2X + i);
+		if ((peaks & bit) && !(r->peaks & bit))
+			memset(r->tp_state[i], 0, sizeof(r->tp_state[i]));
+	}
+
+	r->peaks = peaks;
+}
+
+size_t r128_add_planar(r128_t *r, const float *const *planes, size_t frames, struct r128_block *block,
+		       bool *block_completed)
+{
+	size_t n = r->samples_in_100ms - r->frames_in_block;
+	if (n > frames)
+		n = frames;
+
+	const float *active_planes[R128_MAX_CHANNELS];
+	double sums[R128_MAX_CHANNELS];
+	for (uint32_t i = 0; i < r->n_active; i++)
+		active_planes[i] = planes[r->active[i]];
+
+	kfilter_process_channels(&r->kfilter, r->active_kstate, active_planes, r->n_active, n, sums);
+
+	for (uint32_t i = 0; i < r->n_active; i++) {
+		const uint32_t ch = r->active[i];
+		kfilter_flush_denormals(&r->kstate[ch]);
+		r->block_sum += sums[i] * r->weight[ch];
+	}
+
+	if (r->peaks) {
+		float sample_peak = r->block_peak[R128_PEAK_SAMPLE];
+		for (uint32_t ch = 0; ch < r->channels; ch++) {
+			float peak = sample_peak_process(planes[ch], n);
+			if (peak > sample_peak)
+				sample_peak = peak;
+		}
+		r->block_peak[R128_PEAK_SAMPLE] = sample_peak;
+
+		for (int i = 0; i < N_TP; i++) {
+			const enum r128_peak p = R128_PEAK_TRUE_2X + i;
+			if (!(r->peaks & R128_PEAK_BIT(p)))
+				continue;
+
+			float tp[R128_MAX_CHANNELS];
+			true_peak_process_channels(&r->tp_filter[i], r->tp_state_p[i], planes, r->channels, n, tp);
+
+			float peak = r->block_peak[p] > sample_peak ? r->block_peak[p] : sample_peak;
+			for (uint32_t ch = 0; ch < r->channels; ch++) {
+				if (tp[ch] > peak)
+					peak = tp[ch];
+			}
+			r->block_peak[p] = peak;
+		}
+	}
+
+	r->frames_in_block += n;
+	if (r->frames_in_block >= r->samples_in_100ms) {
+		block->energy = r->block_sum / (double)r->samples_in_100ms;
+		for (int i = 0; i < R128_N_PEAKS; i++)
+			block->peak[i] = (r->peaks & R128_PEAK_BIT(i)) ? r->block_peak[i] : 0.0f;
+
+		r->block_sum = 0.0;
+		memset(r->block_peak, 0, sizeof(r->block_peak));
+		r->frames_in_block = 0;
+		*block_completed = true;
+	}
+
+	return n;
+}
+
+void r128_history_reset(struct r128_history *h)
+{
+	memset(h, 0, sizeof(*h));
+}
+
+void r128_history_add(struct r128_history *h, double energy)
+{
+	h->energy[h->index] = energy;
+	h->index = (h->index + 1) % R128_SHORT_TERM_BLOCKS;
+}
+
+double r128_history_energy(const struct r128_history *h, uint32_t n_blocks)
+{
+	if (n_blocks > R128_SHORT_TERM_BLOCKS)
+		n_blocks = R128_SHORT_TERM_BLOCKS;
+	if (n_blocks == 0)
+		return 0.0;
+
+	double sum = 0.0;
+	uint32_t ix = h->index;
+	for (uint32_t i = 0; i < n_blocks; i++) {
+		ix = (ix + R128_SHORT_TERM_BLOCKS - 1) % R128_SHORT_TERM_BLOCKS;
+		sum += h->energy[ix];
+	}
+
+	return sum / (double)n_blocks;
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* EBU R 128 front-end working directly on the planar frames of OBS.
+ *
+ * The K-weighted energy and the peaks are accumulated in 100 ms blocks.
+ * The front-end does not keep the history of the blocks so that it can be
+ * shared by several accumulators, each with its own `r128_history`. */
+typedef struct r128 r128_t;
+
+#define R128_MAX_CHANNELS 8
+#define R128_MOMENTARY_BLOCKS 4
+#define R128_SHORT_TERM_BLOCKS 30
+
+/* Peak measurements. Several of them can be enabled at the same time. */
+enum r128_peak {
+	R128_PEAK_SAMPLE = 0,
+	R128_PEAK_TRUE_2X = 1,
+	R128_PEAK_TRUE_4X = 2,
+};
+#define R128_N_PEAKS 3
+#define R128_PEAK_BIT(p) (1u << (p))
+
+struct r128_block
+{
+	/* Mean square of the K-weighted and channel-weighted signal */
+	double energy;
+
+	/* Maximum over the channels. The true peaks include the sample peak.
+	 * Measurements that are not enabled are 0. */
+	float peak[R128_N_PEAKS];
+};
+
+r128_t *r128_create(uint32_t channels, uint32_t samplerate);
+void r128_destroy(r128_t *r);
+void r128_reset(r128_t *r);
+
+uint32_t r128_channels(const r128_t *r);
+uint32_t r128_samplerate(const r128_t *r);
+
+/* Returns the measurement to use for the oversampling factor 1, 2, or 4.
+ * The factor is lowered at high sample rates, same as libebur128, and the
+ * sample peak is used at 192 kHz or more. */
+enum r128_peak r128_peak_for_factor(uint32_t samplerate, uint32_t factor);
+
+/* Enables the measurements in the bitmask of `R128_PEAK_BIT`.
+ * Newly enabled interpolators start from the silence. */
+void r128_set_peaks(r128_t *r, uint32_t peaks);
+
+/* Processes the frames up to the next 100 ms boundary and returns the number of frames consumed.
+ * If a 100 ms block is completed, `block` is filled and `block_completed` is set to true. */
+size_t r128_add_planar(r128_t *r, const float *const *planes, size_t frames, struct r128_block *block,
+		       bool *block_completed);
+
+/* The last blocks to derive the momentary and short-term loudness. */
+struct r128_history
+{
+	double energy[R128_SHORT_TERM_BLOCKS];
+	uint32_t index;
+};
+
+void r128_history_reset(struct r128_history *h);
+void r128_history_add(struct r128_history *h, double energy);
+
+/* Returns the mean energy over the last `n_blocks` blocks. */
+double r128_history_energy(const struct r128_history *h, uint32_t n_blocks);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
@@ -0,0 +1,336 @@
+/*
+Loudness Dock for OBS Studio
+Copyright (C) 2025 Norihiro Kamae <norihiro@nagater.net>
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#include <errno.h>
+#include <time.h>
+#include <obs-module.h>
+#include <util/threading.h>
+#include <util/platform.h>
+#include <util/darray.h>
+#include <util/dstr.h>
+#include "session-log.h"
+#include "plugin-macros.generated.h"
+
+#ifdef _WIN32
+#include <io.h>
+#define fsync_file(fp) _commit(_fileno(fp))
+#else
+#include <unistd.h>
+#define fsync_file(fp) fsync(fileno(fp))
+#endif
+
+/* 12.8 seconds of blocks */
+#define QUEUE_SIZE 128
+#define LONG_INTERVAL_BLOCKS 10
+#define WAKE_INTERVAL_MS 500
+#define SYNC_INTERVAL_NS 5000000000ULL
+
+struct session_log_record
+{
+	/* Counts the blocks so that the time of the file does not depend on when the block was analyzed. */
+	uint32_t index;
+	/* Incremented by `session_log_rotate`. A new file begins when it changes. */
+	uint32_t epoch;
+	float values[5];
+};
+
+struct session_log
+{
+	char *name;
+
+	/* Single-producer single-consumer queue.
+	 * `head` is written by the analysis thread, `tail` by the background thread. */
+	struct session_log_record queue[QUEUE_SIZE];
+	volatile long head;
+	volatile long tail;
+	volatile long dropped;
+	uint32_t n_pushed; // Used only by the analysis thread
+	uint32_t epoch;    // Used only by the analysis thread
+
+	volatile bool closing;
+
+	/* Used only by the background thread */
+	FILE *fp;
+	uint32_t start_index;
+	uint32_t file_epoch;
+	uint64_t synced_ns;
+	bool dirty;
+	long dropped_reported;
+};
+
+typedef DARRAY(session_log_t *) session_log_array_t;
+
+static struct
+{
+	/* Protects `logs` and `running` */
+	pthread_mutex_t mutex;
+	session_log_array_t logs;
+	bool running;
+
+	pthread_t thread;
+	os_event_t *stop;
+} writer = {
+	.mutex = PTHREAD_MUTEX_INITIALIZER,
+};
+
+static void close_file(session_log_t *log)
+{
+	if (!log->fp)
+		return;
+
+	fflush(log->fp);
+	fsync_file(log->fp);
+	fclose(log->fp);
+	log->fp = NULL;
+}
+
+/* Replaces the characters that cannot be in a file name. */
+static void append_file_name(struct dstr *path, const char *name)
+{
+	for (const char *p = name; *p; p++) {
+		const char c = *p;
+		const bool invalid = (unsigned char)c < 0x20 || strchr("/\\:*?\"<>|", c);
+		dstr_catf(path, "%c", invalid ? '_' : c);
+	}
+}
+
+static void open_file(session_log_t *log, const struct session_log_record *first, uint64_t now_ns)
+{
+	char *dir = obs_module_config_path("session-logs");
+	os_mkdirs(dir);
+
+	const time_t now = time(NULL);
+	char time_str[32];
+	strftime(time_str, sizeof(time_str), "%Y-%m-%d %H-%M-%S", localtime(&now));
+
+	struct dstr path = {0};
+	dstr_printf(&path, "%s/%s ", dir, time_str);
+	append_file_name(&path, log->name);
+	const size_t len = path.len;
+	dstr_cat(&path, ".csv");
+	for (int i = 2; os_file_exists(path.array); i++) {
+		dstr_resize(&path, len);
+		dstr_catf(&path, "-%d.csv", i);
+	}
+
+	log->fp = os_fopen(path.array, "wb");
+	if (log->fp) {
+		blog(LOG_INFO, "Writing session log '%s'", path.array);
+		strftime(time_str, sizeof(time_str), "%Y-%m-%dT%H:%M:%S", localtime(&now));
+		fprintf(log->fp, "# name=%s start=%s\n", log->name, time_str);
+		fprintf(log->fp, "elapsed,momentary,short,integrated,range,peak\n");
+		log->start_index = first->index;
+		log->file_epoch = first->epoch;
+		log->synced_ns = now_ns;
+	}
+	else {
+		blog(LOG_ERROR, "Failed to open session log '%s'", path.array);
+	}
+
+	dstr_free(&path);
+	bfree(dir);
+}
+
+static void write_record(session_log_t *log, const struct session_log_record *r)
+{
+	const uint32_t n = r->index - log->start_index;
+	const double elapsed = n * 0.1;
+	if (n % LONG_INTERVAL_BLOCKS == 0)
+		fprintf(log->fp, "%.1f,%.2f,%.2f,%.2f,%.2f,%.2f\n", elapsed, r->values[0], r->values[1], r->values[2],
+			r->values[3], r->values[4]);
+	else
+		fprintf(log->fp, "%.1f,%.2f,%.2f,,,\n", elapsed, r->values[0], r->values[1]);
+	log->dirty = true;
+}
+
+/* Called by the background thread. */
+static void drain(session_log_t *log, uint64_t now_ns)
+{
+	const long head = os_atomic_load_long(&log->head);
+	long tail = log->tail;
+	for (; tail != head; tail++) {
+		const struct session_log_record *r = &log->queue[tail % QUEUE_SIZE];
+		/* The blocks before the reset are still written to the previous file. */
+		if (log->fp && r->epoch != log->file_epoch)
+			close_file(log);
+		if (!log->fp)
+			open_file(log, r, now_ns);
+		if (log->fp)
+			write_record(log, r);
+	}
+	/* The slots are released after they are written. */
+	os_atomic_set_long(&log->tail, tail);
+
+	/* Batched so that the disk is not touched for every block. */
+	if (log->fp && log->dirty && now_ns - log->synced_ns >= SYNC_INTERVAL_NS) {
+		fflush(log->fp);
+		fsync_file(log->fp);
+		log->synced_ns = now_ns;
+		log->dirty = false;
+	}
+
+	const long dropped = os_atomic_load_long(&log->dropped);
+	if (dropped != log->dropped_reported) {
+		blog(LOG_WARNING, "Session log '%s': %ld block(s) dropped so far", log->name, dropped);
+		log->dropped_reported = dropped;
+	}
+}
+
+static void free_log(session_log_t *log)
+{
+	close_file(log);
+	bfree(log->name);
+	bfree(log);
+}
+
+static void process_logs(session_log_array_t *logs)
+{
+	pthread_mutex_lock(&writer.mutex);
+	da_copy((*logs), writer.logs);
+	pthread_mutex_unlock(&writer.mutex);
+
+	/* The files are written without the lock so that creating and destroying a log never wait for the disk. */
+	const uint64_t now_ns = os_gettime_ns();
+	for (size_t i = 0; i < logs->num; i++) {
+		session_log_t *log = logs->array[i];
+
+		/* Checked before draining so that the last blocks are written. */
+		const bool closing = os_atomic_load_bool(&log->closing);
+
+		drain(log, now_ns);
+
+		if (closing) {
+			pthread_mutex_lock(&writer.mutex);
+			da_erase_item(writer.logs, &log);
+			pthread_mutex_unlock(&writer.mutex);
+			free_log(log);
+		}
+	}
+}
+
+static void *writer_thread(void *data)
+{
+	UNUSED_PARAMETER(data);
+
+	os_set_thread_name("loudness-log");
+
+	session_log_array_t logs = {0};
+	while (os_event_timedwait(writer.stop, WAKE_INTERVAL_MS) == ETIMEDOUT)
+		process_logs(&logs);
+
+	/* Write the rest and close all the files. */
+	process_logs(&logs);
+	pthread_mutex_lock(&writer.mutex);
+	for (size_t i = 0; i < writer.logs.num; i++)
+		free_log(writer.logs.array[i]);
+	da_free(writer.logs);
+	pthread_mutex_unlock(&writer.mutex);
+
+	da_free(logs);
+	return NULL;
+}
+
+/* Called with `writer.mutex` locked. */
+static bool start_thread(void)
+{
+	if (os_event_init(&writer.stop, OS_EVENT_TYPE_MANUAL) != 0) {
+		blog(LOG_ERROR, "Failed to create event");
+		return false;
+	}
+
+	if (pthread_create(&writer.thread, NULL, writer_thread, NULL) != 0) {
+		blog(LOG_ERROR, "Failed to create session log thread");
+		os_event_destroy(writer.stop);
+		writer.stop = NULL;
+		return false;
+	}
+
+	writer.running = true;
+	return true;
+}
+
+session_log_t *session_log_create(const char *name)
+{
+	session_log_t *log = bzalloc(sizeof(session_log_t));
+	log->name = bstrdup(name);
+
+	pthread_mutex_lock(&writer.mutex);
+	const bool ok = writer.running || start_thread();
+	if (ok)
+		da_push_back(writer.logs, &log);
+	pthread_mutex_unlock(&writer.mutex);
+
+	if (!ok) {
+		free_log(log);
+		return NULL;
+	}
+
+	return log;
+}
+
+void session_log_destroy(session_log_t *log)
+{
+	if (!log)
+		return;
+
+	os_atomic_set_bool(&log->closing, true);
+}
+
+const char *session_log_name(const session_log_t *log)
+{
+	return log->name;
+}
+
+void session_log_push(session_log_t *log, const double results[5])
+{
+	const long head = log->head;
+	if (head - os_atomic_load_long(&log->tail) >= QUEUE_SIZE) {
+		os_atomic_inc_long(&log->dropped);
+		return;
+	}
+
+	struct session_log_record *r = &log->queue[head % QUEUE_SIZE];
+	r->index = log->n_pushed++;
+	r->epoch = log->epoch;
+	for (int i = 0; i < 5; i++)
+		r->values[i] = (float)results[i];
+
+	os_atomic_set_long(&log->head, head + 1);
+}
+
+void session_log_rotate(session_log_t *log)
+{
+	log->epoch++;
+}
+
+void session_log_shutdown(void)
+{
+	pthread_mutex_lock(&writer.mutex);
+	const bool running = writer.running;
+	writer.running = false;
+	pthread_mutex_unlock(&writer.mutex);
+
+	if (!running)
+		return;
+
+	os_event_signal(writer.stop);
+	pthread_join(writer.thread, NULL);
+	os_event_destroy(writer.stop);
+	writer.stop = NULL;
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* CSV log of the loudness of every 100 ms block of a tab.
+ *
+ * The analysis thread pushes the blocks into a bounded queue without locking nor allocating.
+ * A background thread drains the queues of all the logs, writes the files, and flushes them
+ * to the disk every few seconds. If the writer cannot keep up, blocks are dropped and counted.
+ * Each file begins at the first block pushed after `session_log_rotate` so that a file covers one
+ * session of the measurement. */
+typedef struct session_log session_log_t;
+
+/* `name` is included in the file name. */
+session_log_t *session_log_create(const char *name);
+
+/* Returns without waiting. The background thread writes the remaining blocks, closes the file, and frees.
+ * The caller has to ensure that `session_log_push` is not called anymore. */
+void session_log_destroy(session_log_t *log);
+
+const char *session_log_name(const session_log_t *log);
+
+/* Called by the analysis thread. `results` is same as `loudness_get`.
+ * The integrated loudness, LRA, and peak are written once per second. */
+void session_log_push(session_log_t *log, const double results[5]);
+
+/* The next block pushed is written to a new file. The blocks already pushed are written to the current file.
+ * Called by the analysis thread or while it cannot push, i.e. with the analyzer locked. */
+void session_log_rotate(session_log_t *log);
+
+/* Stops the background thread. Called when the module is unloaded. */
+void session_log_shutdown(void);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
@@ -0,0 +1,262 @@
+/*
+Loudness Dock for OBS Studio
+Copyright (C) 2025 Norihiro Kamae <norihiro@nagater.net>
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#include <errno.h>
+#include <obs-module.h>
+#include <util/threading.h>
+#include <util/platform.h>
+#include <util/dstr.h>
+#include "snapshot.h"
+#include "plugin-macros.generated.h"
+
+typedef DARRAY(struct snapshot_client *) snapshot_client_array_t;
+
+static struct
+{
+	/* Serializes starting and stopping the thread. */
+	pthread_mutex_t thread_mutex;
+	pthread_t thread;
+	os_event_t *stop;
+	bool running;
+
+	/* Locked by the thread while saving the clients. */
+	pthread_mutex_t mutex;
+	snapshot_client_array_t clients;
+	bool dir_created;
+} snapshot = {
+	.thread_mutex = PTHREAD_MUTEX_INITIALIZER,
+	.mutex = PTHREAD_MUTEX_INITIALIZER,
+};
+
+/* The key can have any character such as the name of the profile. The file is named by its hash. */
+static char *path_from_key(const char *key, const char *ext)
+{
+	uint64_t hash = 14695981039346656037ULL;
+	for (const char *p = key; *p; p++) {
+		hash ^= (uint8_t)*p;
+		hash *= 1099511628211ULL;
+	}
+
+	char name[64];
+	snprintf(name, sizeof(name), "snapshot/%016llx.%s", (unsigned long long)hash, ext);
+	return obs_module_config_path(name);
+}
+
+static bool write_file(const char *path, const uint8_t *data, size_t size)
+{
+	struct dstr tmp = {0};
+	dstr_printf(&tmp, "%s.tmp", path);
+
+	bool ok = false;
+	FILE *fp = os_fopen(tmp.array, "wb");
+	if (fp) {
+		ok = fwrite(data, 1, size, fp) == size;
+		ok = fclose(fp) == 0 && ok;
+	}
+
+	/* Replaced only after the new file is complete. */
+	if (ok)
+		ok = os_safe_replace(path, tmp.array, NULL) == 0;
+	else
+		os_unlink(tmp.array);
+
+	if (!ok)
+		blog(LOG_WARNING, "Failed to write snapshot '%s'", path);
+
+	dstr_free(&tmp);
+	return ok;
+}
+
+static bool write_journal(const char *path, const uint8_t *data, size_t size, bool restart)
+{
+	bool ok = false;
+	FILE *fp = os_fopen(path, restart ? "wb" : "ab");
+	if (fp) {
+		ok = fwrite(data, 1, size, fp) == size;
+		ok = fclose(fp) == 0 && ok;
+	}
+
+	if (!ok)
+		blog(LOG_WARNING, "Failed to write snapshot journal '%s'", path);
+
+	return ok;
+}
+
+static void save_clients(snapshot_buffer_t *buf, struct snapshot_journal *journal, struct dstr *path,
+			 struct dstr *journal_path)
+{
+	pthread_mutex_lock(&snapshot.mutex);
+
+	for (size_t i = 0; i < snapshot.clients.num; i++) {
+		struct snapshot_client *c = snapshot.clients.array[i];
+
+		da_resize((*buf), 0);
+		da_resize(journal->data, 0);
+		journal->restart = c->journal_failed;
+		if (!c->save_cb(c->param, buf, journal))
+			continue;
+		c->journal_failed = false;
+		dstr_copy(path, c->path);
+		dstr_copy(journal_path, c->journal_path);
+
+		if (!snapshot.dir_created) {
+			char *dir = obs_module_config_path("snapshot");
+			os_mkdirs(dir);
+			bfree(dir);
+			snapshot.dir_created = true;
+		}
+
+		/* The files are written from the copy so that the client can be removed meanwhile.
+		 * The journal goes first so that the file never records more of the journal than is written. */
+		pthread_mutex_unlock(&snapshot.mutex);
+		bool ok = true;
+		if (journal->data.num || journal->restart)
+			ok = write_journal(journal_path->array, journal->data.array, journal->data.num, journal->restart);
+		if (ok)
+			write_file(path->array, buf->array, buf->num);
+		pthread_mutex_lock(&snapshot.mutex);
+
+		if (!ok && da_find(snapshot.clients, &c, 0) != DARRAY_INVALID)
+			c->journal_failed = true;
+	}
+
+	pthread_mutex_unlock(&snapshot.mutex);
+}
+
+static void *snapshot_thread(void *data)
+{
+	UNUSED_PARAMETER(data);
+
+	os_set_thread_name("loudness-snapshot");
+
+	snapshot_buffer_t buf = {0};
+	struct snapshot_journal journal = {0};
+	struct dstr path = {0};
+	struct dstr journal_path = {0};
+
+	while (os_event_timedwait(snapshot.stop, SNAPSHOT_INTERVAL_SECONDS * 1000) == ETIMEDOUT)
+		save_clients(&buf, &journal, &path, &journal_path);
+
+	da_free(buf);
+	da_free(journal.data);
+	dstr_free(&path);
+	dstr_free(&journal_path);
+	return NULL;
+}
+
+static bool start_thread(void)
+{
+	if (os_event_init(&snapshot.stop, OS_EVENT_TYPE_MANUAL) != 0) {
+		blog(LOG_ERROR, "Failed to create event");
+		return false;
+	}
+
+	if (pthread_create(&snapshot.thread, NULL, snapshot_thread, NULL) != 0) {
+		blog(LOG_ERROR, "Failed to create snapshot thread");
+		os_event_destroy(snapshot.stop);
+		snapshot.stop = NULL;
+		return false;
+	}
+
+	snapshot.running = true;
+	return true;
+}
+
+/* Called without `snapshot.mutex` locked since the thread locks it until it stops. */
+static void stop_thread(void)
+{
+	os_event_signal(snapshot.stop);
+	pthread_join(snapshot.thread, NULL);
+	os_event_destroy(snapshot.stop);
+	snapshot.stop = NULL;
+	snapshot.running = false;
+}
+
+void snapshot_add_client(struct snapshot_client *c, const char *key)
+{
+	c->path = path_from_key(key, "bin");
+	c->journal_path = path_from_key(key, "journal");
+	c->journal_failed = false;
+
+	pthread_mutex_lock(&snapshot.thread_mutex);
+	if (snapshot.running || start_thread()) {
+		pthread_mutex_lock(&snapshot.mutex);
+		da_push_back(snapshot.clients, &c);
+		pthread_mutex_unlock(&snapshot.mutex);
+	}
+	pthread_mutex_unlock(&snapshot.thread_mutex);
+}
+
+void snapshot_remove_client(struct snapshot_client *c)
+{
+	pthread_mutex_lock(&snapshot.thread_mutex);
+
+	/* Waits for the thread if it is saving the clients. */
+	pthread_mutex_lock(&snapshot.mutex);
+	da_erase_item(snapshot.clients, &c);
+	const bool last = !snapshot.clients.num;
+	if (last)
+		da_free(snapshot.clients);
+	pthread_mutex_unlock(&snapshot.mutex);
+
+	if (last && snapshot.running)
+		stop_thread();
+
+	pthread_mutex_unlock(&snapshot.thread_mutex);
+
+	bfree(c->path);
+	bfree(c->journal_path);
+	c->path = NULL;
+	c->journal_path = NULL;
+}
+
+static uint8_t *read_file(const char *key, const char *ext, size_t *size)
+{
+	char *path = path_from_key(key, ext);
+	FILE *fp = os_fopen(path, "rb");
+	bfree(path);
+	if (!fp)
+		return NULL;
+
+	uint8_t *data = NULL;
+	const int64_t file_size = os_fgetsize(fp);
+	if (file_size > 0) {
+		data = bmalloc((size_t)file_size);
+		if (fread(data, 1, (size_t)file_size, fp) == (size_t)file_size) {
+			*size = (size_t)file_size;
+		}
+		else {
+			bfree(data);
+			data = NULL;
+		}
+	}
+
+	fclose(fp);
+	return data;
+}
+
+uint8_t *snapshot_read(const char *key, size_t *size)
+{
+	return read_file(key, "bin", size);
+}
+
+uint8_t *snapshot_read_journal(const char *key, size_t *size)
+{
+	return read_file(key, "journal", size);
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <string.h>
+#include <util/darray.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Checkpoints of the accumulated loudness so that a restart of OBS does not start over.
+ *
+ * A background thread asks each client to serialize its state every `SNAPSHOT_INTERVAL_SECONDS`
+ * and writes it to the file of the client. The file is written under a temporary name and then
+ * renamed so that a crash while writing leaves the previous checkpoint.
+ * Data that only grows during a session, such as the gating blocks, goes to a journal instead.
+ * Only the data added since the last checkpoint is appended to the journal, before the file is replaced,
+ * and the file records how much of the journal belongs to it.
+ * Neither the UI thread nor the audio thread touches the files except for reading them at restore. */
+
+#define SNAPSHOT_INTERVAL_SECONDS 5
+
+typedef DARRAY(uint8_t) snapshot_buffer_t;
+
+struct snapshot_journal
+{
+	/* Appended to the journal */
+	snapshot_buffer_t data;
+	/* Set by the client to discard the journal before appending `data`. */
+	bool restart;
+};
+
+struct snapshot_client
+{
+	/* Called by the snapshot thread. Appends the state to `buf` and the new data to `journal`.
+	 * Returns false if the state did not change since the last call. */
+	bool (*save_cb)(void *param, snapshot_buffer_t *buf, struct snapshot_journal *journal);
+	void *param;
+
+	/* Set by `snapshot_add_client` from the key. */
+	char *path;
+	char *journal_path;
+
+	/* Set by the snapshot thread if the journal could not be written. The client has to restart the journal
+	 * at the next call of `save_cb` since the data appended by the last call is missing. */
+	bool journal_failed;
+};
+
+/* Starts the thread with the first client. */
+void snapshot_add_client(struct snapshot_client *c, const char *key);
+
+/* Waits if the client is being saved so that `save_cb` is never called after this returns.
+ * The file is kept for the next restart. The thread stops with the last client. */
+void snapshot_remove_client(struct snapshot_client *c);
+
+/* Reads the file of the key. Returns NULL if there is no file. The data has to be freed by `bfree`. */
+uint8_t *snapshot_read(const char *key, size_t *size);
+
+/* Reads the journal of the key in the same way as `snapshot_read`.
+ * The journal can be longer than the file records if OBS stopped between writing the two. */
+uint8_t *snapshot_read_journal(const char *key, size_t *size);
+
+static inline void snapshot_write(snapshot_buffer_t *buf, const void *data, size_t size)
+{
+	da_push_back_array((*buf), (const uint8_t *)data, size);
+}
+
+struct snapshot_reader
+{
+	const uint8_t *data;
+	size_t size;
+	size_t pos;
+};
+
+/* Returns false without reading anything if the data is shorter than `size`. */
+static inline bool snapshot_read_data(struct snapshot_reader *r, void *data, size_t size)
+{
+	if (size > r->size - r->pos)
+		return false;
+	memcpy(data, r->data + r->pos, size);
+	r->pos += size;
+	return true;
+}
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
@@ -0,0 +1,42 @@
+#pragma once
+#include <memory>
+#include <string>
+#include <vector>
+#include "loudness.h"
+
+/* The tabs seen by the websocket handlers.
+ * The UI thread builds a new table whenever the tabs or the current tab change and publishes it by
+ * `std::atomic_store`. A table is never modified once published so that the websocket threads resolve
+ * the names without waiting for the UI thread. The contexts are shared with the dock so that a context
+ * removed by the UI thread lives until the last table referring it is released. The deleter of the dock
+ * passes the destruction to the UI thread if the last table is released by a websocket thread. */
+struct tab_table
+{
+	struct tab
+	{
+		std::string name;
+		std::shared_ptr<loudness_t> loudness;
+		int trigger_mode;
+	};
+
+	std::vector<tab> tabs;
+	int current = 0;
+
+	loudness_t *find(const char *name) const
+	{
+		for (const tab &t : tabs) {
+			if (t.name == name)
+				return t.loudness.get();
+		}
+		return nullptr;
+	}
+
+	loudness_t *get_current() const
+	{
+		if (current < 0 && tabs.size())
+			return tabs[0].loudness.get();
+		if (0 <= current && current < (int)tabs.size())
+			return tabs[current].loudness.get();
+		return nullptr;
+	}
+};
@@ -0,0 +1,243 @@
+/*
+Loudness Dock for OBS Studio
+Copyright (C) 2025 Norihiro Kamae <norihiro@nagater.net>
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+/* Vectorized true-peak interpolator. Each lane holds one channel and the delay-line position
+ * is shared by the lanes. The accumulation is in the same order as `true_peak_process`
+ * without FMA so that the results are bit-exact. */
+
+#include "true-peak.h"
+#include "kfilter.h"
+
+#ifdef KFILTER_X86
+
+#include <immintrin.h>
+#ifdef _MSC_VER
+#define TARGET_AVX2
+#else
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+void true_peak_process_sse2(const struct true_peak_filter *f, struct true_peak_state *const *s,
+			    const float *const *in, size_t n, float *peaks)
+{
+	struct true_peak_state *s0 = s[0], *s1 = s[1];
+	const float *in0 = in[0], *in1 = in[1];
+	const __m128 sign = _mm_set1_ps(-0.0f);
+	__m128 peak = _mm_setzero_ps();
+	uint32_t zi = s0->zi;
+
+	for (size_t i = 0; i < n; i++) {
+		s0->z[zi] = s0->z[zi + f->delay] = in0[i];
+		s1->z[zi] = s1->z[zi + f->delay] = in1[i];
+
+		for (uint32_t phase = 0; phase < f->factor; phase++) {
+			__m128d acc = _mm_setzero_pd();
+			for (uint32_t t = 0; t < f->count[phase]; t++) {
+				int k = (int)zi - (int)f->index[phase][t];
+				if (k < 0)
+					k += (int)f->delay;
+				__m128d z = _mm_set_pd((double)s1->z[k], (double)s0->z[k]);
+				acc = _mm_add_pd(acc, _mm_mul_pd(z, _mm_set1_pd(f->coeff[phase][t])));
+			}
+			__m128 v = _mm_andnot_ps(sign, _mm_cvtpd_ps(acc));
+			peak = _mm_max_ps(v, peak);
+		}
+
+		if (++zi == f->delay)
+			zi = 0;
+	}
+
+	s0->zi = zi;
+	s1->zi = zi;
+
+	float tmp[4];
+	_mm_storeu_ps(tmp, peak);
+	peaks[0] = tmp[0];
+	peaks[1] = tmp[1];
+}
+
+TARGET_AVX2 void true_peak_process_avx2(const struct true_peak_filter *f, struct true_peak_state *const *s,
+					const float *const *in, size_t n, float *peaks)
+{
+	struct true_peak_state *s0 = s[0], *s1 = s[1], *s2 = s[2], *s3 = s[3];
+	const float *in0 = in[0], *in1 = in[1], *in2 = in[2], *in3 = in[3];
+	const __m128 sign = _mm_set1_ps(-0.0f);
+	__m128 peak = _mm_setzero_ps();
+	uint32_t zi = s0->zi;
+
+	for (size_t i = 0; i < n; i++) {
+		s0->z[zi] = s0->z[zi + f->delay] = in0[i];
+		s1->z[zi] = s1->z[zi + f->delay] = in1[i];
+		s2->z[zi] = s2->z[zi + f->delay] = in2[i];
+		s3->z[zi] = s3->z[zi + f->delay] = in3[i];
+
+		for (uint32_t phase = 0; phase < f->factor; phase++) {
+			__m256d acc = _mm256_setzero_pd();
+			for (uint32_t t = 0; t < f->count[phase]; t++) {
+				int k = (int)zi - (int)f->index[phase][t];
+				if (k < 0)
+					k += (int)f->delay;
+				__m256d z = _mm256_cvtps_pd(_mm_set_ps(s3->z[k], s2->z[k], s1->z[k], s0->z[k]));
+				acc = _mm256_add_pd(acc, _mm256_mul_pd(z, _mm256_set1_pd(f->coeff[phase][t])));
+			}
+			__m128 v = _mm_andnot_ps(sign, _mm256_cvtpd_ps(acc));
+			peak = _mm_max_ps(v, peak);
+		}
+
+		if (++zi == f->delay)
+			zi = 0;
+	}
+
+	s0->zi = zi;
+	s1->zi = zi;
+	s2->zi = zi;
+	s3->zi = zi;
+
+	float tmp[4];
+	_mm_storeu_ps(tmp, peak);
+	peaks[0] = tmp[0];
+	peaks[1] = tmp[1];
+	peaks[2] = tmp[2];
+	peaks[3] = tmp[3];
+}
+
+/* Specialized for `fixed_factor`, see `process_fixed` in true-peak.c */
+static inline void process_sse2_fixed(const struct true_peak_filter *f, struct true_peak_state *const *s,
+				      const float *const *in, size_t n, float *peaks, const uint32_t factor)
+{
+	const uint32_t delay = TRUE_PEAK_FIXED_DELAY(factor);
+	const uint32_t taps = TRUE_PEAK_FIXED_TAPS(factor);
+	const int center = TRUE_PEAK_CENTER / factor;
+	struct true_peak_state *s0 = s[0], *s1 = s[1];
+	const float *in0 = in[0], *in1 = in[1];
+	const __m128 sign = _mm_set1_ps(-0.0f);
+	const __m128d c0 = _mm_set1_pd(f->coeff[0][0]);
+	__m128 peak = _mm_setzero_ps();
+	uint32_t zi = s0->zi;
+
+	for (size_t i = 0; i < n; i++) {
+		s0->z[zi] = s0->z[zi + delay] = in0[i];
+		s1->z[zi] = s1->z[zi + delay] = in1[i];
+
+		const float *z0 = s0->z + zi + delay, *z1 = s1->z + zi + delay;
+
+		__m128d acc = _mm_mul_pd(_mm_set_pd((double)z1[-center], (double)z0[-center]), c0);
+		peak = _mm_max_ps(_mm_andnot_ps(sign, _mm_cvtpd_ps(acc)), peak);
+
+		for (uint32_t phase = 1; phase < factor; phase++) {
+			acc = _mm_setzero_pd();
+			for (uint32_t t = 0; t < taps; t++) {
+				__m128d z = _mm_set_pd((double)z1[-(int)t], (double)z0[-(int)t]);
+				acc = _mm_add_pd(acc, _mm_mul_pd(z, _mm_set1_pd(f->coeff[phase][t])));
+			}
+			peak = _mm_max_ps(_mm_andnot_ps(sign, _mm_cvtpd_ps(acc)), peak);
+		}
+
+		if (++zi == delay)
+			zi = 0;
+	}
+
+	s0->zi = zi;
+	s1->zi = zi;
+
+	float tmp[4];
+	_mm_storeu_ps(tmp, peak);
+	peaks[0] = tmp[0];
+	peaks[1] = tmp[1];
+}
+
+void true_peak_process_sse2_fixed2(const struct true_peak_filter *f, struct true_peak_state *const *s,
+				   const float *const *in, size_t n, float *peaks)
+{
+	process_sse2_fixed(f, s, in, n, peaks, 2);
+}
+
+void true_peak_process_sse2_fixed4(const struct true_peak_filter *f, struct true_peak_state *const *s,
+				   const float *const *in, size_t n, float *peaks)
+{
+	process_sse2_fixed(f, s, in, n, peaks, 4);
+}
+
+static inline TARGET_AVX2 void process_avx2_fixed(const struct true_peak_filter *f, struct true_peak_state *const *s,
+						  const float *const *in, size_t n, float *peaks,
+						  const uint32_t factor)
+{
+	const uint32_t delay = TRUE_PEAK_FIXED_DELAY(factor);
+	const uint32_t taps = TRUE_PEAK_FIXED_TAPS(factor);
+	const int center = TRUE_PEAK_CENTER / factor;
+	struct true_peak_state *s0 = s[0], *s1 = s[1], *s2 = s[2], *s3 = s[3];
+	const float *in0 = in[0], *in1 = in[1], *in2 = in[2], *in3 = in[3];
+	const __m128 sign = _mm_set1_ps(-0.0f);
+	const __m256d c0 = _mm256_set1_pd(f->coeff[0][0]);
+	__m128 peak = _mm_setzero_ps();
+	uint32_t zi = s0->zi;
+
+	for (size_t i = 0; i < n; i++) {
+		s0->z[zi] = s0->z[zi + delay] = in0[i];
+		s1->z[zi] = s1->z[zi + delay] = in1[i];
+		s2->z[zi] = s2->z[zi + delay] = in2[i];
+		s3->z[zi] = s3->z[zi + delay] = in3[i];
+
+		const float *z0 = s0->z + zi + delay, *z1 = s1->z + zi + delay;
+		const float *z2 = s2->z + zi + delay, *z3 = s3->z + zi + delay;
+
+		__m256d acc = _mm256_mul_pd(
+			_mm256_cvtps_pd(_mm_set_ps(z3[-center], z2[-center], z1[-center], z0[-center])), c0);
+		peak = _mm_max_ps(_mm_andnot_ps(sign, _mm256_cvtpd_ps(acc)), peak);
+
+		for (uint32_t phase = 1; phase < factor; phase++) {
+			acc = _mm256_setzero_pd();
+			for (uint32_t t = 0; t < taps; t++) {
+				const int k = -(int)t;
+				__m256d z = _mm256_cvtps_pd(_mm_set_ps(z3[k], z2[k], z1[k], z0[k]));
+				acc = _mm256_add_pd(acc, _mm256_mul_pd(z, _mm256_set1_pd(f->coeff[phase][t])));
+			}
+			peak = _mm_max_ps(_mm_andnot_ps(sign, _mm256_cvtpd_ps(acc)), peak);
+		}
+
+		if (++zi == delay)
+			zi = 0;
+	}
+
+	s0->zi = zi;
+	s1->zi = zi;
+	s2->zi = zi;
+	s3->zi = zi;
+
+	float tmp[4];
+	_mm_storeu_ps(tmp, peak);
+	peaks[0] = tmp[0];
+	peaks[1] = tmp[1];
+	peaks[2] = tmp[2];
+	peaks[3] = tmp[3];
+}
+
+TARGET_AVX2 void true_peak_process_avx2_fixed2(const struct true_peak_filter *f, struct true_peak_state *const *s,
+					       const float *const *in, size_t n, float *peaks)
+{
+	process_avx2_fixed(f, s, in, n, peaks, 2);
+}
+
+TARGET_AVX2 void true_peak_process_avx2_fixed4(const struct true_peak_filter *f, struct true_peak_state *const *s,
+					       const float *const *in, size_t n, float *peaks)
+{
+	process_avx2_fixed(f, s, in, n, peaks, 4);
+}
+
+#endif
@@ -0,0 +1,220 @@
+/*
+Loudness Dock for OBS Studio
+Copyright (C) 2025 Norihiro Kamae <norihiro@nagater.net>
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#include <math.h>
+#include <string.h>
+#include <stdbool.h>
+#include "true-peak.h"
+#include "kfilter.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define ALMOST_ZERO 0.000001
+
+uint32_t true_peak_factor_for_rate(uint32_t samplerate)
+{
+	if (samplerate < 96000)
+		return 4;
+	if (samplerate < 192000)
+		return 2;
+	return 1;
+}
+
+static bool has_fixed_layout(const struct true_peak_filter *f)
+{
+	const uint32_t factor = f->factor;
+	if (factor != 2 && factor != 4)
+		return false;
+	if (f->delay != TRUE_PEAK_FIXED_DELAY(factor))
+		return false;
+
+	if (f->count[0] != 1 || f->index[0][0] != TRUE_PEAK_CENTER / factor)
+		return false;
+
+	for (uint32_t phase = 1; phase < factor; phase++) {
+		if (f->count[phase] != TRUE_PEAK_FIXED_TAPS(factor))
+			return false;
+		for (uint32_t t = 0; t < f->count[phase]; t++) {
+			if (f->index[phase][t] != t)
+				return false;
+		}
+	}
+
+	return true;
+}
+
+void true_peak_init_filter(struct true_peak_filter *f, uint32_t factor)
+{
+	memset(f, 0, sizeof(*f));
+	f->factor = factor;
+	f->delay = (TRUE_PEAK_TAPS + factor - 1) / factor;
+
+	for (uint32_t j = 0; j < TRUE_PEAK_TAPS; j++) {
+		double m = (double)j - (double)(TRUE_PEAK_TAPS - 1) / 2.0;
+		double c = 1.0;
+		if (fabs(m) > ALMOST_ZERO)
+			c = sin(m * M_PI / factor) / (m * M_PI / factor);
+
+		/* Hanning window */
+		c *= 0.5 * (1 - cos(2 * M_PI * j / (TRUE_PEAK_TAPS - 1)));
+
+		/* Ignore zero coefficients */
+		if (fabs(c) > ALMOST_ZERO) {
+			uint32_t phase = j % factor;
+			uint32_t t = f->count[phase]++;
+			f->coeff[phase][t] = c;
+			f->index[phase][t] = j / factor;
+		}
+	}
+
+	f->fixed_factor = has_fixed_layout(f) ? factor : 0;
+}
+
+float true_peak_process(const struct true_peak_filter *f, struct true_peak_state *s, const float *in, size_t n)
+{
+	float peak = 0.0f;
+	uint32_t zi = s->zi;
+
+	for (size_t i = 0; i < n; i++) {
+		s->z[zi] = in[i];
+		s->z[zi + f->delay] = in[i];
+
+		for (uint32_t phase = 0; phase < f->factor; phase++) {
+			double acc = 0.0;
+			for (uint32_t t = 0; t < f->count[phase]; t++) {
+				int k = (int)zi - (int)f->index[phase][t];
+				if (k < 0)
+					k += (int)f->delay;
+				acc += (double)s->z[k] * f->coeff[phase][t];
+			}
+			float v = fabsf((float)acc);
+			if (v > peak)
+				peak = v;
+		}
+
+		if (++zi == f->delay)
+			zi = 0;
+	}
+
+	s->zi = zi;
+	return peak;
+}
+
+/* Same as `true_peak_process` with the factor and the taps known at compile time.
+ * The compiler unrolls the phases, and the taps are read without the wrap-around. */
+static inline float process_fixed(const struct true_peak_filter *f, struct true_peak_state *s, const float *in,
+				  size_t n, const uint32_t factor)
+{
+	const uint32_t delay = TRUE_PEAK_FIXED_DELAY(factor);
+	const uint32_t taps = TRUE_PEAK_FIXED_TAPS(factor);
+	float peak = 0.0f;
+	uint32_t zi = s->zi;
+
+	for (size_t i = 0; i < n; i++) {
+		s->z[zi] = in[i];
+		s->z[zi + delay] = in[i];
+
+		/* z[-t] is the sample t frames before. */
+		const float *z = s->z + zi + delay;
+
+		float v = fabsf((float)((double)z[-(int)(TRUE_PEAK_CENTER / factor)] * f->coeff[0][0]));
+		if (v > peak)
+			peak = v;
+
+		for (uint32_t phase = 1; phase < factor; phase++) {
+			double acc = 0.0;
+			for (uint32_t t = 0; t < taps; t++)
+				acc += (double)z[-(int)t] * f->coeff[phase][t];
+			v = fabsf((float)acc);
+			if (v > peak)
+				peak = v;
+		}
+
+		if (++zi == delay)
+			zi = 0;
+	}
+
+	s->zi = zi;
+	return peak;
+}
+
+static float process_fixed2(const struct true_peak_filter *f, struct true_peak_state *s, const float *in, size_t n)
+{
+	return process_fixed(f, s, in, n, 2);
+}
+
+static float process_fixed4(const struct true_peak_filter *f, struct true_peak_state *s, const float *in, size_t n)
+{
+	return process_fixed(f, s, in, n, 4);
+}
+
+typedef float (*process1_t)(const struct true_peak_filter *, struct true_peak_state *, const float *, size_t);
+typedef void (*process_lanes_t)(const struct true_peak_filter *, struct true_peak_state *const *,
+				const float *const *, size_t, float *);
+
+void true_peak_process_channels(const struct true_peak_filter *f, struct true_peak_state *const *s,
+				const float *const *in, uint32_t n_ch, size_t n, float *peaks)
+{
+	uint32_t ch = 0;
+
+	process1_t process1 = true_peak_process;
+	if (f->fixed_factor == 4)
+		process1 = process_fixed4;
+	else if (f->fixed_factor == 2)
+		process1 = process_fixed2;
+
+#ifdef KFILTER_X86
+	process_lanes_t avx2 = true_peak_process_avx2;
+	process_lanes_t sse2 = true_peak_process_sse2;
+	if (f->fixed_factor == 4) {
+		avx2 = true_peak_process_avx2_fixed4;
+		sse2 = true_peak_process_sse2_fixed4;
+	}
+	else if (f->fixed_factor == 2) {
+		avx2 = true_peak_process_avx2_fixed2;
+		sse2 = true_peak_process_sse2_fixed2;
+	}
+
+	const enum kfilter_kernel kernel = kfilter_get_kernel();
+	if (kernel >= KFILTER_KERNEL_AVX2) {
+		for (; ch + 4 <= n_ch; ch += 4)
+			avx2(f, s + ch, in + ch, n, peaks + ch);
+	}
+	if (kernel >= KFILTER_KERNEL_SSE2) {
+		for (; ch + 2 <= n_ch; ch += 2)
+			sse2(f, s + ch, in + ch, n, peaks + ch);
+	}
+#endif
+
+	for (; ch < n_ch; ch++)
+		peaks[ch] = process1(f, s[ch], in[ch], n);
+}
+
+float sample_peak_process(const float *in, size_t n)
+{
+	float peak = 0.0f;
+	for (size_t i = 0; i < n; i++) {
+		float v = fabsf(in[i]);
+		if (v > peak)
+			peak = v;
+	}
+	return peak;
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Polyphase interpolator to detect the true peak of one channel.
+ * The design follows libebur128: a Hanning-windowed sinc of 49 taps. */
+
+#define TRUE_PEAK_TAPS 49
+#define TRUE_PEAK_MAX_FACTOR 4
+/* The delay line is the longest for the factor 2. */
+#define TRUE_PEAK_MAX_DELAY ((TRUE_PEAK_TAPS + 1) / 2)
+
+struct true_peak_filter
+{
+	uint32_t factor;
+	uint32_t delay;
+	uint32_t count[TRUE_PEAK_MAX_FACTOR];
+	uint32_t index[TRUE_PEAK_MAX_FACTOR][TRUE_PEAK_MAX_DELAY];
+	double coeff[TRUE_PEAK_MAX_FACTOR][TRUE_PEAK_MAX_DELAY];
+
+	/* Set to `factor` if the taps have the layout assumed by the kernels specialized for
+	 * the factors 2 and 4, otherwise 0 so that the generic kernels are used. */
+	uint32_t fixed_factor;
+};
+
+struct true_peak_state
+{
+	/* The delay line is mirrored at `z[zi + delay]` so that the specialized kernels
+	 * read the taps without wrapping around. */
+	float z[TRUE_PEAK_MAX_DELAY * 2];
+	uint32_t zi;
+};
+
+/* Returns the oversampling factor used by libebur128 for the sample rate. */
+uint32_t true_peak_factor_for_rate(uint32_t samplerate);
+
+/* `factor` has to be 2 or 4. */
+void true_peak_init_filter(struct true_peak_filter *f, uint32_t factor);
+
+/* Interpolates `n` samples and returns the maximum absolute value of the oversampled signal. */
+float true_peak_process(const struct true_peak_filter *f, struct true_peak_state *s, const float *in, size_t n);
+
+/* Interpolates `n_ch` channels at once, each channel in a lane of the kernel selected by
+ * `kfilter_select_kernel`. The states have to be processed always together so that they
+ * share the same delay-line position. `peaks` receives the peak of each channel.
+ * The results are bit-exact to `true_peak_process`. */
+void true_peak_process_channels(const struct true_peak_filter *f, struct true_peak_state *const *s,
+				const float *const *in, uint32_t n_ch, size_t n, float *peaks);
+
+/* Kernels processing 2 and 4 channels in the lanes, implemented in true-peak-x86.c
+ * The `_fixed2` and `_fixed4` variants are specialized for `fixed_factor`. */
+void true_peak_process_sse2(const struct true_peak_filter *f, struct true_peak_state *const *s,
+			    const float *const *in, size_t n, float *peaks);
+void true_peak_process_avx2(const struct true_peak_filter *f, struct true_peak_state *const *s,
+			    const float *const *in, size_t n, float *peaks);
+void true_peak_process_sse2_fixed2(const struct true_peak_filter *f, struct true_peak_state *const *s,
+				   const float *const *in, size_t n, float *peaks);
+void true_peak_process_sse2_fixed4(const struct true_peak_filter *f, struct true_peak_state *const *s,
+				   const float *const *in, size_t n, float *peaks);
+void true_peak_process_avx2_fixed2(const struct true_peak_filter *f, struct true_peak_state *const *s,
+				   const float *const *in, size_t n, float *peaks);
+void true_peak_process_avx2_fixed4(const struct true_peak_filter *f, struct true_peak_state *const *s,
+				   const float *const *in, size_t n, float *peaks);
+
+/* Taps of the specialized kernels. The phase 0 has only the center tap, the other phases have
+ * `TRUE_PEAK_FIXED_TAPS(factor)` taps at the consecutive positions of the delay line. */
+#define TRUE_PEAK_CENTER ((TRUE_PEAK_TAPS - 1) / 2)
+#define TRUE_PEAK_FIXED_DELAY(factor) ((TRUE_PEAK_TAPS + (factor) - 1) / (factor))
+#define TRUE_PEAK_FIXED_TAPS(factor) ((TRUE_PEAK_TAPS - 1) / (factor))
+
+/* Returns the maximum absolute value of the samples. */
+float sample_peak_process(const float *in, size_t n);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
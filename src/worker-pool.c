@@ -0,0 +1,207 @@
+/*
+Loudness Dock for OBS Studio
+Copyright (C) 2025 Norihiro Kamae <norihiro@nagater.net>
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#include <obs-module.h>
+#include <util/threading.h>
+#include <util/platform.h>
+#include <util/darray.h>
+#include "worker-pool.h"
+#include "plugin-macros.generated.h"
+
+#define MAX_WORKERS 4
+
+typedef DARRAY(struct worker_job *) job_array_t;
+
+struct worker
+{
+	pthread_t thread;
+	os_sem_t *sem;
+	volatile bool stop;
+
+	/* Protects `jobs`, `changes`, and `running`. Not held while a job runs so that a job waiting for the lock
+	 * of its analyzer does not hold `worker_pool_remove` of the other jobs. */
+	pthread_mutex_t mutex;
+	job_array_t jobs;
+	/* Incremented when a job is removed so that the worker scans the jobs again from the first. */
+	uint64_t changes;
+	/* The job being run, signaled by `idle` when it returns */
+	struct worker_job *running;
+	pthread_cond_t idle;
+};
+
+static struct
+{
+	pthread_mutex_t mutex;
+	size_t n_jobs;
+	size_t n_workers;
+	struct worker workers[MAX_WORKERS];
+} pool = {
+	.mutex = PTHREAD_MUTEX_INITIALIZER,
+};
+
+static void *worker_thread(void *data)
+{
+	struct worker *w = data;
+
+	os_set_thread_name("loudness-worker");
+
+	while (os_sem_wait(w->sem) == 0) {
+		if (os_atomic_load_bool(&w->stop))
+			break;
+
+		pthread_mutex_lock(&w->mutex);
+		size_t i = 0;
+		while (i < w->jobs.num) {
+			struct worker_job *job = w->jobs.array[i];
+			/* Clear before running so that a request during the run is not lost. */
+			if (!os_atomic_set_long(&job->pending, 0)) {
+				i++;
+				continue;
+			}
+
+			const uint64_t changes = w->changes;
+			w->running = job;
+			pthread_mutex_unlock(&w->mutex);
+
+			job->run(job->param);
+
+			pthread_mutex_lock(&w->mutex);
+			w->running = NULL;
+			pthread_cond_broadcast(&w->idle);
+
+			/* A pending job is never skipped since its request has already consumed the semaphore. */
+			i = w->changes == changes ? i + 1 : 0;
+		}
+		pthread_mutex_unlock(&w->mutex);
+	}
+
+	return NULL;
+}
+
+static size_t pool_size(void)
+{
+	/* Leave the other cores for OBS itself. */
+	int n = os_get_logical_cores() / 2;
+	if (n < 1)
+		n = 1;
+	if (n > MAX_WORKERS)
+		n = MAX_WORKERS;
+	return (size_t)n;
+}
+
+static void stop_workers(void)
+{
+	for (size_t i = 0; i < pool.n_workers; i++) {
+		struct worker *w = &pool.workers[i];
+		os_atomic_set_bool(&w->stop, true);
+		os_sem_post(w->sem);
+		pthread_join(w->thread, NULL);
+		os_sem_destroy(w->sem);
+		pthread_mutex_destroy(&w->mutex);
+		pthread_cond_destroy(&w->idle);
+		da_free(w->jobs);
+		memset(w, 0, sizeof(*w));
+	}
+	pool.n_workers = 0;
+}
+
+static bool start_workers(void)
+{
+	const size_t n = pool_size();
+
+	for (size_t i = 0; i < n; i++) {
+		struct worker *w = &pool.workers[i];
+		if (os_sem_init(&w->sem, 0) != 0) {
+			blog(LOG_ERROR, "Failed to create semaphore");
+			stop_workers();
+			return false;
+		}
+		pthread_mutex_init(&w->mutex, NULL);
+		pthread_cond_init(&w->idle, NULL);
+		if (pthread_create(&w->thread, NULL, worker_thread, w) != 0) {
+			blog(LOG_ERROR, "Failed to create analysis thread");
+			os_sem_destroy(w->sem);
+			pthread_mutex_destroy(&w->mutex);
+			pthread_cond_destroy(&w->idle);
+			stop_workers();
+			return false;
+		}
+		pool.n_workers++;
+	}
+
+	blog(LOG_INFO, "started %zu analysis worker(s)", pool.n_workers);
+	return true;
+}
+
+bool worker_pool_add(struct worker_job *job)
+{
+	pthread_mutex_lock(&pool.mutex);
+
+	if (!pool.n_workers && !start_workers()) {
+		pthread_mutex_unlock(&pool.mutex);
+		return false;
+	}
+
+	struct worker *w = &pool.workers[0];
+	for (size_t i = 1; i < pool.n_workers; i++) {
+		if (pool.workers[i].jobs.num < w->jobs.num)
+			w = &pool.workers[i];
+	}
+
+	job->pending = 0;
+	job->worker = w;
+
+	pthread_mutex_lock(&w->mutex);
+	da_push_back(w->jobs, &job);
+	pthread_mutex_unlock(&w->mutex);
+
+	pool.n_jobs++;
+
+	pthread_mutex_unlock(&pool.mutex);
+	return true;
+}
+
+void worker_pool_remove(struct worker_job *job)
+{
+	struct worker *w = job->worker;
+	if (!w)
+		return;
+
+	pthread_mutex_lock(&pool.mutex);
+
+	/* Waits for the worker only if it is running this job. */
+	pthread_mutex_lock(&w->mutex);
+	da_erase_item(w->jobs, &job);
+	w->changes++;
+	while (w->running == job)
+		pthread_cond_wait(&w->idle, &w->mutex);
+	pthread_mutex_unlock(&w->mutex);
+	job->worker = NULL;
+
+	if (--pool.n_jobs == 0)
+		stop_workers();
+
+	pthread_mutex_unlock(&pool.mutex);
+}
+
+void worker_job_schedule(struct worker_job *job)
+{
+	if (os_atomic_set_long(&job->pending, 1) == 0)
+		os_sem_post(job->worker->sem);
+}
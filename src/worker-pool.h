@@ -0,0 +1,41 @@
+#pragma once
+
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Fixed pool of analysis threads shared by all analyzers.
+ *
+ * Each job is bound to one worker when it is added so that a job never runs on two
+ * workers at once and needs no lock of its own. The workers are not pinned to cores;
+ * the scheduler of the OS decides where they run. The jobs are spread over the
+ * workers by the number of jobs. */
+
+struct worker;
+
+struct worker_job
+{
+	void (*run)(void *param);
+	void *param;
+
+	/* Managed by the pool. */
+	volatile long pending;
+	struct worker *worker;
+};
+
+/* Binds the job to a worker. The pool is started with the first job. */
+bool worker_pool_add(struct worker_job *job);
+
+/* Unbinds the job. Waits if the job is running so that `run` is never called after this returns.
+ * The pool is stopped with the last job. */
+void worker_pool_remove(struct worker_job *job);
+
+/* Requests the worker to call `run` of the job. Never locks nor allocates so that the audio thread can call.
+ * Requests made while the job is already pending are merged. */
+void worker_job_schedule(struct worker_job *job);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
@@ -0,0 +1,279 @@
+/*
+Loudness Dock for OBS Studio
+Copyright (C) 2025 Norihiro Kamae <norihiro@nagater.net>
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+/* Compares the refresh of `LoudnessPanel` with the refresh of the widgets that the dock had before,
+ * a `QLabel` for each value and a meter drawing everything at each paint kept below as `ReferenceMeter`,
+ * under the offscreen platform of Qt.
+ * Each iteration sets new values and levels to all the rows as the dock does for each block, and processes
+ * the events so that the requested update regions are painted. Another pass repaints the whole widgets.
+ * Run with the number of the rows as the argument to see how the cost grows with the rows, and with
+ * QT_SCALE_FACTOR=2 to see a device pixel ratio of 2. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <vector>
+#include <QApplication>
+#include <QGridLayout>
+#include <QLabel>
+#include <QPainter>
+#include <QPaintEvent>
+#include "loudness-panel.hpp"
+
+#define WIDTH 400
+#define ITERATIONS 2000
+#define N_BARS 3
+
+typedef std::chrono::steady_clock bench_clock;
+
+/* The paint before the background was cached */
+class ReferenceMeter : public QWidget {
+	struct color_s
+	{
+		float level;
+		QColor color_fg;
+		QColor color_bg;
+	};
+
+	float min = -59.0f;
+	float max = -5.0f;
+	float current = -99;
+	int current_int = -1;
+	int tick_height = 4;
+	int font_height, font_width;
+	QFont meter_font;
+	std::vector<color_s> colors;
+
+	int toX(float value, const QRect &widgetRect) const
+	{
+		value = std::max(std::min(value, max), min);
+		float x = (value - min) / (max - min);
+		return (int)((widgetRect.width() - font_width) * x) + font_width / 2;
+	}
+
+public:
+	ReferenceMeter()
+	{
+		colors.push_back({-23.0, QColor(0, 0, 255), QColor(0, 0, 85)});
+		colors.push_back({-14.0, QColor(0, 255, 0), QColor(0, 85, 0)});
+		colors.push_back({0.0, QColor(255, 0, 0), QColor(85, 0, 0)});
+
+		meter_font = font();
+		meter_font.setPointSizeF(QFontInfo(meter_font).pointSizeF() * 0.7);
+		meter_font.setFixedPitch(true);
+		QFontMetrics metrics(meter_font);
+		setMinimumSize(64, 8 + metrics.capHeight());
+		font_height = metrics.capHeight();
+		font_width = metrics.boundingRect("-88").width();
+	}
+
+	void setLevel(float level)
+	{
+		current = level;
+		QRect widgetRect = rect();
+		int next_int = toX(level, widgetRect);
+		if (next_int == current_int)
+			return;
+		int x0 = std::max(std::min(next_int, current_int) - 1, 0);
+		int x1 = std::min(std::max(next_int, current_int) + 1, widgetRect.width());
+		update(QRect(x0, 0, x1 - x0, widgetRect.height() - tick_height - font_height + 1));
+	}
+
+protected:
+	void paintEvent(QPaintEvent *event) override
+	{
+		QRect widgetRect = rect();
+		int width = widgetRect.width();
+		int height = widgetRect.height();
+
+		QPainter painter(this);
+
+		current_int = toX(current, widgetRect);
+
+		int last = toX(min, widgetRect);
+		for (const auto &c : colors) {
+			int level_int = toX(c.level, widgetRect);
+			QRect fill_rect;
+			fill_rect.setTop(0);
+			fill_rect.setBottom(height - tick_height - font_height);
+			if (last < current_int) {
+				fill_rect.setLeft(last);
+				fill_rect.setRight(std::min(current_int, level_int));
+				painter.fillRect(fill_rect, c.color_fg);
+			}
+			if (current_int < level_int) {
+				fill_rect.setLeft(std::max(current_int, last));
+				fill_rect.setRight(level_int);
+				painter.fillRect(fill_rect, c.color_bg);
+			}
+			last = level_int;
+		}
+
+		const int y2 = height - font_height;
+		const int y1 = y2 - tick_height;
+		if (event->region().boundingRect().bottom() <= y1)
+			return;
+
+		painter.setFont(meter_font);
+		QFontMetrics metrics(meter_font);
+
+		float tick_step = (max - min) * font_width / width * 1.2;
+		tick_step = std::ceil(tick_step / 10.0) * 10.0;
+		float tick_start = std::ceil(min / tick_step) * tick_step;
+		for (float tick = tick_start; tick <= max; tick += tick_step) {
+			int pos = toX(tick, widgetRect);
+			painter.drawLine(pos, y1, pos, y2);
+			QString str = QString::number(tick);
+			QRect b = metrics.boundingRect(str);
+			painter.drawText(pos - b.width() / 2, height, str);
+		}
+	}
+};
+
+/* The layout of the dock before the panel */
+class ReferenceWidgets : public QWidget {
+	std::vector<QLabel *> values;
+	std::vector<ReferenceMeter *> meters;
+
+public:
+	ReferenceWidgets(int n_rows)
+	{
+		auto *layout = new QGridLayout(this);
+		layout->setColumnStretch(3, 1);
+		for (int row = 0; row < n_rows; row++) {
+			layout->addWidget(new QLabel(QStringLiteral("Row %1").arg(row), this), row, 0);
+
+			QLabel *value = new QLabel("-", this);
+			value->setAlignment(Qt::AlignRight | Qt::AlignVCenter);
+			value->setMinimumWidth(value->fontMetrics().boundingRect("-199.0").width());
+			layout->addWidget(value, row, 1);
+			values.push_back(value);
+
+			layout->addWidget(new QLabel("LUFS", this), row, 2);
+
+			if (row < N_BARS) {
+				auto *meter = new ReferenceMeter();
+				layout->addWidget(meter, row, 3);
+				meters.push_back(meter);
+			}
+		}
+	}
+
+	void setValue(int row, double value)
+	{
+		values[row]->setText(QStringLiteral("%1").arg(value, 2, 'f', 1));
+		if (row < (int)meters.size())
+			meters[row]->setLevel(value);
+	}
+};
+
+class PanelWidget : public LoudnessPanel {
+public:
+	PanelWidget(int n_rows)
+	{
+		for (int row = 0; row < n_rows; row++) {
+			addRow(QStringLiteral("Row %1").arg(row), "LUFS", row < N_BARS);
+			/* Named as the dock names its rows after the former labels */
+			setValueObjectName(row, QStringLiteral("r128_row%1").arg(row));
+		}
+	}
+
+	void setValue(int row, double value)
+	{
+		LoudnessPanel::setValue(row, value);
+		setLevel(row, value);
+	}
+};
+
+/* Counts the paint events that actually reached the widgets. */
+class PaintCounter : public QObject {
+public:
+	int n = 0;
+
+protected:
+	bool eventFilter(QObject *, QEvent *event) override
+	{
+		if (event->type() == QEvent::Paint)
+			n++;
+		return false;
+	}
+};
+
+static float level_at(int i)
+{
+	/* Speech-like movement of the momentary loudness, a few dB for each block */
+	return -30.0f + 12.0f * std::sin(i * 0.37f) + 4.0f * std::sin(i * 1.9f);
+}
+
+/* Returns the microseconds of an iteration. */
+template<typename T> static double bench(const char *name, T &widget, int n_rows, bool full)
+{
+	/* The paint events of the children are counted as well. */
+	PaintCounter counter;
+	QList<QWidget *> children = widget.template findChildren<QWidget *>();
+	children.append(&widget);
+	for (QWidget *w : children)
+		w->installEventFilter(&counter);
+
+	const auto start = bench_clock::now();
+	for (int i = 0; i < ITERATIONS; i++) {
+		for (int row = 0; row < n_rows; row++)
+			widget.setValue(row, level_at(i + row * 7));
+		if (full)
+			widget.repaint();
+		else
+			QApplication::processEvents();
+	}
+	const double us = std::chrono::duration<double, std::micro>(bench_clock::now() - start).count();
+
+	for (QWidget *w : children)
+		w->removeEventFilter(&counter);
+	printf("%-10s %-6s paints=%6d %8.2f us/iteration\n", name, full ? "full" : "update", counter.n,
+	       us / ITERATIONS);
+	return us / ITERATIONS;
+}
+
+int main(int argc, char **argv)
+{
+	if (qgetenv("QT_QPA_PLATFORM").isEmpty())
+		qputenv("QT_QPA_PLATFORM", "offscreen");
+
+	QApplication app(argc, argv);
+	const int n_rows = argc > 1 ? std::max(atoi(argv[1]), 1) : 5;
+
+	ReferenceWidgets reference(n_rows);
+	PanelWidget panel(n_rows);
+	for (QWidget *w : std::vector<QWidget *>{&reference, &panel}) {
+		w->resize(WIDTH, w->sizeHint().height());
+		w->show();
+	}
+	QApplication::processEvents();
+
+	printf("%d rows, device pixel ratio %.1f\n", n_rows, panel.devicePixelRatioF());
+
+	for (int full = 0; full < 2; full++) {
+		const double us_reference = bench("widgets", reference, n_rows, full);
+		const double us_panel = bench("panel", panel, n_rows, full);
+		printf("%-17s %8.2fx faster\n", full ? "full" : "update", us_reference / us_panel);
+	}
+
+	return 0;
+}
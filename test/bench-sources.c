@@ -0,0 +1,143 @@
+/*
+Loudness Dock for OBS Studio
+Copyright (C) 2025 Norihiro Kamae <norihiro@nagater.net>
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+/* Measures the cost of measuring many sources at once.
+ * A thread plays the audio thread of OBS: every tick, it pushes one packet to the ring of each
+ * source and schedules its job, as the audio capture callback does. The time spent there is
+ * what each source adds to the audio thread. The workers drain the rings in the background. */
+
+#include <stdio.h>
+#include <math.h>
+#include <obs-module.h>
+#include <util/threading.h>
+#include <util/platform.h>
+#include "worker-pool.h"
+#include "audio-ring.h"
+#include "r128.h"
+#include "kfilter.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define MAX_SOURCES 32
+#define PACKET_FRAMES AUDIO_OUTPUT_FRAMES
+#define RING_FRAMES (AUDIO_OUTPUT_FRAMES * 8) /* same as the ring of a source */
+#define PACKETS 2000                          /* about 43 seconds of audio */
+
+static float packet[2][PACKET_FRAMES];
+
+struct bench_source
+{
+	struct worker_job job;
+	struct audio_ring ring;
+	r128_t *r128;
+	uint64_t blocks;
+};
+
+static void run(void *param)
+{
+	struct bench_source *s = param;
+
+	size_t offset;
+	size_t frames;
+	while ((frames = audio_ring_peek(&s->ring, &offset)) > 0) {
+		const float *planes[2] = {audio_ring_plane(&s->ring, 0) + offset, audio_ring_plane(&s->ring, 1) + offset};
+		size_t done = 0;
+		while (done < frames) {
+			const float *in[2] = {planes[0] + done, planes[1] + done};
+			struct r128_block block;
+			bool block_completed = false;
+			done += r128_add_planar(s->r128, in, frames - done, &block, &block_completed);
+			if (block_completed)
+				s->blocks++;
+		}
+		audio_ring_consume(&s->ring, frames);
+	}
+}
+
+static void bench(size_t n)
+{
+	static struct bench_source sources[MAX_SOURCES];
+
+	for (size_t i = 0; i < n; i++) {
+		struct bench_source *s = &sources[i];
+		s->r128 = r128_create(2, 48000);
+		r128_set_peaks(s->r128, R128_PEAK_BIT(R128_PEAK_TRUE_4X));
+		audio_ring_init(&s->ring, 2, RING_FRAMES);
+		s->blocks = 0;
+		s->job.run = run;
+		s->job.param = s;
+		worker_pool_add(&s->job);
+	}
+
+	const float *planes[2] = {packet[0], packet[1]};
+	uint64_t push_ns = 0;
+	const uint64_t start = os_gettime_ns();
+
+	for (int p = 0; p < PACKETS; p++) {
+		/* Retry a full ring as the next tick of the audio thread would bring more data anyway;
+		 * this measures the throughput without dropping. */
+		for (size_t i = 0; i < n; i++) {
+			const uint64_t t0 = os_gettime_ns();
+			bool pushed = audio_ring_push(&sources[i].ring, planes, PACKET_FRAMES);
+			if (pushed)
+				worker_job_schedule(&sources[i].job);
+			push_ns += os_gettime_ns() - t0;
+			if (!pushed) {
+				os_sleep_ms(1);
+				i--;
+			}
+		}
+	}
+	for (size_t i = 0; i < n; i++) {
+		while (audio_ring_available(&sources[i].ring) > 0)
+			os_sleep_ms(1);
+	}
+
+	const double elapsed = (double)(os_gettime_ns() - start) * 1e-9;
+	const double audio = (double)PACKETS * PACKET_FRAMES / 48000.0 * (double)n;
+	long overruns = 0;
+	for (size_t i = 0; i < n; i++)
+		overruns += os_atomic_load_long(&sources[i].ring.overruns);
+
+	printf("sources=%2zu elapsed=%7.3f s realtime=%8.1fx audio-thread=%6.0f ns/source/tick ring-full=%ld\n", n,
+	       elapsed, audio / elapsed, (double)push_ns / ((double)PACKETS * (double)n), overruns);
+
+	for (size_t i = 0; i < n; i++) {
+		worker_pool_remove(&sources[i].job);
+		audio_ring_free(&sources[i].ring);
+		r128_destroy(sources[i].r128);
+	}
+}
+
+int main()
+{
+	kfilter_select_kernel();
+
+	for (int i = 0; i < PACKET_FRAMES; i++)
+		packet[0][i] = packet[1][i] = (float)(0.1 * sin(2.0 * M_PI * 997.0 * i / 48000.0));
+
+	printf("logical cores=%d kernel=%s\n", os_get_logical_cores(), kfilter_kernel_name(kfilter_get_kernel()));
+	static const size_t counts[] = {1, 8, 16, 24, 32};
+	for (size_t i = 0; i < sizeof(counts) / sizeof(*counts); i++)
+		bench(counts[i]);
+
+	return 0;
+}
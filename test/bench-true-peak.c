@@ -0,0 +1,100 @@
+/*
+Loudness Dock for OBS Studio
+Copyright (C) 2025 Norihiro Kamae <norihiro@nagater.net>
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+/* Compares the generic true-peak kernels with the kernels specialized for the factor
+ * for the channel layouts and the sample rates used by OBS. */
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "true-peak.h"
+#include "kfilter.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define MAX_CH 8
+#define PACKET_FRAMES 1024
+#define SECONDS 20
+
+static float packet[MAX_CH][PACKET_FRAMES];
+
+static double now(void)
+{
+	struct timespec ts;
+	timespec_get(&ts, TIME_UTC);
+	return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+/* Returns how many times faster than realtime. */
+static double bench(uint32_t n_ch, uint32_t samplerate, bool fixed)
+{
+	struct true_peak_filter f;
+	struct true_peak_state states[MAX_CH];
+	struct true_peak_state *s[MAX_CH];
+	const float *in[MAX_CH];
+	float peaks[MAX_CH];
+
+	true_peak_init_filter(&f, true_peak_factor_for_rate(samplerate));
+	if (!fixed)
+		f.fixed_factor = 0;
+	memset(states, 0, sizeof(states));
+	for (uint32_t ch = 0; ch < n_ch; ch++) {
+		s[ch] = &states[ch];
+		in[ch] = packet[ch];
+	}
+
+	const size_t packets = (size_t)samplerate * SECONDS / PACKET_FRAMES;
+	volatile float sink = 0.0f;
+	const double start = now();
+	for (size_t p = 0; p < packets; p++) {
+		true_peak_process_channels(&f, s, in, n_ch, PACKET_FRAMES, peaks);
+		sink = peaks[0];
+	}
+	(void)sink;
+
+	return (double)SECONDS / (now() - start);
+}
+
+int main()
+{
+	kfilter_select_kernel();
+
+	for (uint32_t ch = 0; ch < MAX_CH; ch++) {
+		for (int i = 0; i < PACKET_FRAMES; i++)
+			packet[ch][i] = (float)(0.1 * sin(2.0 * M_PI * 997.0 * (i + ch) / 48000.0));
+	}
+
+	static const uint32_t layouts[] = {1, 2, 6, 8};
+	static const uint32_t rates[] = {44100, 48000};
+
+	printf("kernel=%s\n", kfilter_kernel_name(kfilter_get_kernel()));
+	for (size_t r = 0; r < sizeof(rates) / sizeof(*rates); r++) {
+		for (size_t l = 0; l < sizeof(layouts) / sizeof(*layouts); l++) {
+			const double generic = bench(layouts[l], rates[r], false);
+			const double fixed = bench(layouts[l], rates[r], true);
+			printf("rate=%u channels=%u generic=%7.1fx specialized=%7.1fx gain=%4.2f\n", rates[r],
+			       layouts[l], generic, fixed, fixed / generic);
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,118 @@
+/*
+Loudness Dock for OBS Studio
+Copyright (C) 2025 Norihiro Kamae <norihiro@nagater.net>
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+/* Measures how the analysis scales with the number of analyzers sharing the worker pool.
+ * Each analyzer runs the K-weighting filter and the 4x true-peak interpolator on stereo 48 kHz. */
+
+#include <stdio.h>
+#include <math.h>
+#include <obs-module.h>
+#include <util/threading.h>
+#include <util/platform.h>
+#include "worker-pool.h"
+#include "r128.h"
+#include "kfilter.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define MAX_ANALYZERS 16
+#define PACKET_FRAMES 1024
+#define PACKETS 2000 /* about 43 seconds of audio */
+
+static float packet[2][PACKET_FRAMES];
+
+struct bench_analyzer
+{
+	struct worker_job job;
+	r128_t *r128;
+	volatile long queued;
+	volatile long done;
+};
+
+static void run(void *param)
+{
+	struct bench_analyzer *a = param;
+	const float *planes[2] = {packet[0], packet[1]};
+
+	while (os_atomic_load_long(&a->queued) > os_atomic_load_long(&a->done)) {
+		size_t offset = 0;
+		while (offset < PACKET_FRAMES) {
+			const float *in[2] = {planes[0] + offset, planes[1] + offset};
+			struct r128_block block;
+			bool block_completed = false;
+			offset += r128_add_planar(a->r128, in, PACKET_FRAMES - offset, &block, &block_completed);
+		}
+		os_atomic_inc_long(&a->done);
+	}
+}
+
+static void bench(size_t n)
+{
+	static struct bench_analyzer analyzers[MAX_ANALYZERS];
+
+	for (size_t i = 0; i < n; i++) {
+		struct bench_analyzer *a = &analyzers[i];
+		a->r128 = r128_create(2, 48000);
+		r128_set_peaks(a->r128, R128_PEAK_BIT(R128_PEAK_TRUE_4X));
+		a->queued = a->done = 0;
+		a->job.run = run;
+		a->job.param = a;
+		worker_pool_add(&a->job);
+	}
+
+	const uint64_t start = os_gettime_ns();
+
+	/* Queue the packets as an audio thread would do, then wait for all to be processed. */
+	for (int p = 0; p < PACKETS; p++) {
+		for (size_t i = 0; i < n; i++) {
+			os_atomic_inc_long(&analyzers[i].queued);
+			worker_job_schedule(&analyzers[i].job);
+		}
+	}
+	for (size_t i = 0; i < n; i++) {
+		while (os_atomic_load_long(&analyzers[i].done) < PACKETS)
+			os_sleep_ms(1);
+	}
+
+	const double elapsed = (double)(os_gettime_ns() - start) * 1e-9;
+	const double audio = (double)PACKETS * PACKET_FRAMES / 48000.0 * (double)n;
+	printf("analyzers=%2zu elapsed=%7.3f s realtime=%8.1fx per-analyzer=%7.1fx\n", n, elapsed, audio / elapsed,
+	       audio / elapsed / (double)n);
+
+	for (size_t i = 0; i < n; i++) {
+		worker_pool_remove(&analyzers[i].job);
+		r128_destroy(analyzers[i].r128);
+	}
+}
+
+int main()
+{
+	kfilter_select_kernel();
+
+	for (int i = 0; i < PACKET_FRAMES; i++)
+		packet[0][i] = packet[1][i] = (float)(0.1 * sin(2.0 * M_PI * 997.0 * i / 48000.0));
+
+	printf("logical cores=%d kernel=%s\n", os_get_logical_cores(), kfilter_kernel_name(kfilter_get_kernel()));
+	for (size_t n = 1; n <= MAX_ANALYZERS; n *= 2)
+		bench(n);
+
+	return 0;
+}
@@ -0,0 +1,232 @@
+/*
+Loudness Dock for OBS Studio
+Copyright (C) 2025 Norihiro Kamae <norihiro@nagater.net>
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+/* Measures the latency of `get_loudness` seen by the websocket thread.
+ * libobs is started with audio only so that the contexts are measuring the first track while the requests
+ * are served. The UI task handler is served by a thread playing the Qt event loop: it stalls for a while
+ * periodically as a scene transition or a big dialog does.
+ * The former path hops to that thread by `obs_queue_task` and waits, as `run_in_ui_and_wait` did.
+ * The current path resolves the name in the published `tab_table` and calls `loudness_get` on the
+ * websocket thread. */
+
+#include <stdio.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <obs.h>
+#include <util/platform.h>
+#include "tab-table.hpp"
+
+#define N_TABS 8
+#define REQUESTS 300
+#define REQUEST_INTERVAL_MS 10
+#define STALL_PERIOD_MS 500
+#define STALL_MS 150
+
+struct ui_thread
+{
+	struct task
+	{
+		obs_task_t fn;
+		void *param;
+	};
+
+	std::mutex mutex;
+	std::condition_variable cond;
+	std::deque<task> tasks;
+	bool stop = false;
+	std::thread thread;
+
+	void run()
+	{
+		uint64_t next_stall = os_gettime_ns() + STALL_PERIOD_MS * 1000000ull;
+		std::unique_lock<std::mutex> lock(mutex);
+		while (!stop) {
+			if (os_gettime_ns() >= next_stall) {
+				lock.unlock();
+				os_sleep_ms(STALL_MS);
+				lock.lock();
+				next_stall += STALL_PERIOD_MS * 1000000ull;
+				continue;
+			}
+			if (tasks.empty()) {
+				cond.wait_for(lock, std::chrono::milliseconds(1));
+				continue;
+			}
+			task t = tasks.front();
+			tasks.pop_front();
+			lock.unlock();
+			t.fn(t.param);
+			lock.lock();
+		}
+	}
+
+	void queue(obs_task_t fn, void *param)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		tasks.push_back({fn, param});
+		cond.notify_one();
+	}
+};
+
+static ui_thread ui;
+
+struct waited_task
+{
+	obs_task_t fn;
+	void *param;
+	std::mutex mutex;
+	std::condition_variable cond;
+	bool done = false;
+};
+
+static void run_waited_task(void *param)
+{
+	auto *w = static_cast<waited_task *>(param);
+	w->fn(w->param);
+	std::lock_guard<std::mutex> lock(w->mutex);
+	w->done = true;
+	w->cond.notify_one();
+}
+
+/* Same as the handler of the frontend: a blocking queued connection if `wait` is set. */
+static void ui_task_handler(obs_task_t task, void *param, bool wait)
+{
+	if (!wait) {
+		ui.queue(task, param);
+		return;
+	}
+
+	waited_task w;
+	w.fn = task;
+	w.param = param;
+	ui.queue(run_waited_task, &w);
+	std::unique_lock<std::mutex> lock(w.mutex);
+	w.cond.wait(lock, [&] { return w.done; });
+}
+
+template<typename F> static void run_functor(void *data)
+{
+	auto &fp = *static_cast<F *>(data);
+	fp();
+}
+
+/* The former helper of the dock. The websocket thread is never the UI thread here. */
+template<typename F> static void run_in_ui_and_wait(F f)
+{
+	obs_queue_task(OBS_TASK_UI, run_functor<F>, &f, true);
+}
+
+static std::shared_ptr<const tab_table> published_tabs;
+
+static void request_via_ui(const char *name, double res[5])
+{
+	run_in_ui_and_wait([&]() {
+		std::shared_ptr<const tab_table> tabs = std::atomic_load(&published_tabs);
+		if (loudness_t *loudness = tabs->find(name))
+			loudness_get(loudness, res, LOUDNESS_GET_SHORT | LOUDNESS_GET_LONG);
+	});
+}
+
+static void request_direct(const char *name, double res[5])
+{
+	std::shared_ptr<const tab_table> tabs = std::atomic_load(&published_tabs);
+	if (loudness_t *loudness = tabs->find(name))
+		loudness_get(loudness, res, LOUDNESS_GET_SHORT | LOUDNESS_GET_LONG);
+}
+
+static void bench(const char *label, void (*request)(const char *, double[5]))
+{
+	std::vector<double> us;
+	us.reserve(REQUESTS);
+	double sink = 0.0;
+
+	/* Requests are sent from another thread as obs-websocket does. */
+	std::thread ws([&]() {
+		for (int i = 0; i < REQUESTS; i++) {
+			const std::string name = "tab" + std::to_string(i % N_TABS);
+			double res[5] = {0};
+			const uint64_t t0 = os_gettime_ns();
+			request(name.c_str(), res);
+			us.push_back((double)(os_gettime_ns() - t0) * 1e-3);
+			sink += res[0];
+			os_sleep_ms(REQUEST_INTERVAL_MS);
+		}
+	});
+	ws.join();
+
+	std::sort(us.begin(), us.end());
+	printf("%-9s p50=%9.1f us p99=%9.1f us max=%9.1f us (momentary %.1f LUFS)\n", label, us[us.size() / 2],
+	       us[us.size() * 99 / 100], us.back(), sink / REQUESTS);
+}
+
+int main()
+{
+	if (!obs_startup("en-US", nullptr, nullptr)) {
+		fprintf(stderr, "obs_startup failed\n");
+		return 1;
+	}
+	struct obs_audio_info oai = {};
+	oai.samples_per_sec = 48000;
+	oai.speakers = SPEAKERS_STEREO;
+	if (!obs_reset_audio(&oai)) {
+		fprintf(stderr, "obs_reset_audio failed\n");
+		obs_shutdown();
+		return 1;
+	}
+
+	obs_set_ui_task_handler(ui_task_handler);
+	ui.thread = std::thread([]() { ui.run(); });
+
+	auto tabs = std::make_shared<tab_table>();
+	for (int i = 0; i < N_TABS; i++) {
+		tab_table::tab t;
+		t.name = "tab" + std::to_string(i);
+		t.loudness = std::shared_ptr<loudness_t>(loudness_create(0, 0), loudness_destroy);
+		t.trigger_mode = 0;
+		tabs->tabs.push_back(std::move(t));
+	}
+	std::atomic_store(&published_tabs, std::shared_ptr<const tab_table>(tabs));
+	tabs.reset();
+
+	/* Let the contexts measure a few blocks. */
+	os_sleep_ms(500);
+
+	printf("%d tabs, a request every %d ms, the UI stalls %d ms every %d ms\n", N_TABS, REQUEST_INTERVAL_MS,
+	       STALL_MS, STALL_PERIOD_MS);
+	bench("via-ui", request_via_ui);
+	bench("direct", request_direct);
+
+	{
+		std::lock_guard<std::mutex> lock(ui.mutex);
+		ui.stop = true;
+	}
+	ui.thread.join();
+
+	std::atomic_store(&published_tabs, std::shared_ptr<const tab_table>());
+	obs_shutdown();
+	return 0;
+}
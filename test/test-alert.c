@@ -0,0 +1,134 @@
+/*
+Loudness Dock for OBS Studio
+Copyright (C) 2025 Norihiro Kamae <norihiro@nagater.net>
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+/* Checks the durations, the release, and the arming of the alert rules. */
+
+#include <stdio.h>
+#include <math.h>
+#include "alert.h"
+
+#define MAX_EVENTS 16
+
+struct events
+{
+	int n;
+	int block[MAX_EVENTS];
+	int rule[MAX_EVENTS];
+	bool active[MAX_EVENTS];
+};
+
+static int current_block;
+
+static void cb(void *param, const struct alert_event *event)
+{
+	struct events *e = param;
+	if (e->n >= MAX_EVENTS)
+		return;
+	e->block[e->n] = current_block;
+	e->rule[e->n] = event->rule[0] - 'a';
+	e->active[e->n] = event->active;
+	e->n++;
+}
+
+static int expect(const char *what, long long value, long long expected)
+{
+	if (value == expected)
+		return 0;
+	printf("Error: %s: %lld, expected %lld\n", what, value, expected);
+	return 1;
+}
+
+static void feed(alert_set_t *s, int n, double short_term, double integrated, double peak)
+{
+	const double results[5] = {short_term, short_term, integrated, 0.0, peak};
+	for (int i = 0; i < n; i++) {
+		alert_set_update(s, results, peak);
+		current_block++;
+	}
+}
+
+int main()
+{
+	int ret = 0;
+
+	const struct alert_rule rules[] = {
+		{"a-quiet", ALERT_SHORT_BELOW, -36.0, 0.0, 2.0},
+		{"b-peak", ALERT_PEAK_OVER, -1.0, 0.0, 0.0},
+		{"c-drift", ALERT_INTEGRATED_DRIFT, -23.0, 1.0, 5.0},
+	};
+	struct events e = {0};
+	alert_set_t *s = alert_set_create("tab", rules, 3, cb, &e);
+
+	/* Quiet for 2 s activates at the 20th block, loud for 2 s deactivates at the 20th block. */
+	current_block = 0;
+	feed(s, 30, -50.0, -23.0, -10.0);
+	feed(s, 25, -20.0, -23.0, -10.0);
+	ret |= expect("events after quiet", e.n, 2);
+	ret |= expect("quiet rule", e.rule[0], 0);
+	ret |= expect("quiet activated", e.active[0], 1);
+	ret |= expect("quiet activated at", e.block[0], 19);
+	ret |= expect("quiet deactivated", e.active[1], 0);
+	ret |= expect("quiet deactivated at", e.block[1], 30 + 19);
+
+	/* A quiet gap shorter than the duration does not fire. */
+	e.n = 0;
+	feed(s, 19, -50.0, -23.0, -10.0);
+	feed(s, 5, -20.0, -23.0, -10.0);
+	ret |= expect("short gap", e.n, 0);
+
+	/* The peak fires at the first block and holds for the release time. */
+	e.n = 0;
+	const int peak_start = current_block;
+	feed(s, 1, -20.0, -23.0, 0.5);
+	feed(s, 3, -20.0, -23.0, -10.0);
+	feed(s, 1, -20.0, -23.0, 0.5);
+	feed(s, 12, -20.0, -23.0, -10.0);
+	ret |= expect("peak events", e.n, 2);
+	ret |= expect("peak rule", e.rule[0], 1);
+	ret |= expect("peak activated at", e.block[0], peak_start);
+	ret |= expect("peak deactivated at", e.block[1], peak_start + 4 + ALERT_RELEASE_BLOCKS);
+
+	/* No integrated loudness yet is not a drift. */
+	e.n = 0;
+	feed(s, 100, -20.0, -HUGE_VAL, -10.0);
+	ret |= expect("no integrated", e.n, 0);
+	feed(s, 50, -20.0, -21.5, -10.0);
+	ret |= expect("drift", e.n, 1);
+	ret |= expect("drift rule", e.rule[0], 2);
+
+	/* Disarming ends the active rule and stops the evaluation. */
+	alert_set_arm(s, false);
+	ret |= expect("disarmed", e.n, 2);
+	ret |= expect("drift ended", e.active[1], 0);
+	feed(s, 50, -50.0, -21.5, 0.5);
+	ret |= expect("disarmed events", e.n, 2);
+
+	alert_set_arm(s, true);
+	feed(s, 1, -50.0, -21.5, 0.5);
+	ret |= expect("rearmed peak", e.n, 3);
+
+	ret |= expect("equals", alert_set_equals(s, "tab", rules, 3, cb, &e), 1);
+	ret |= expect("differs", alert_set_equals(s, "tab", rules, 2, cb, &e), 0);
+
+	alert_set_destroy(s);
+
+	if (!ret)
+		printf("OK\n");
+	return ret;
+}
@@ -0,0 +1,239 @@
+/*
+Loudness Dock for OBS Studio
+Copyright (C) 2025 Norihiro Kamae <norihiro@nagater.net>
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+/* Compares the histogram mode against the exact mode of `gating_t`, the exact mode against
+ * the gates computed directly from all the blocks, and checks that a snapshot restores the same results. */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include "gating.h"
+
+static uint32_t rand_state = 1;
+
+static double rand_uniform(void)
+{
+	rand_state = rand_state * 1103515245u + 12345u;
+	return (double)(rand_state >> 8) / (double)(1u << 24);
+}
+
+/* Program-like loudness: a random walk around -23 LUFS with silent gaps. */
+static double next_lufs(double *walk, double base, int i)
+{
+	*walk += (base - *walk) * 0.01 + (rand_uniform() - 0.5) * 1.5;
+	if (*walk < -40.0)
+		*walk = -40.0;
+	if (*walk > -8.0)
+		*walk = -8.0;
+
+	if ((i / 600) % 7 == 6)
+		return -90.0 + rand_uniform() * 10.0;
+	return *walk + (rand_uniform() - 0.5) * 6.0;
+}
+
+static int check(const char *what, double expected, double actual, double tolerance)
+{
+	double diff = expected == actual ? 0.0 : fabs(expected - actual);
+	printf("%-13s expected=%8.3f actual=%8.3f diff=%6.3f\n", what, expected, actual, diff);
+	if (!(diff <= tolerance)) {
+		printf("Error: %s differs more than %.2f\n", what, tolerance);
+		return 1;
+	}
+	return 0;
+}
+
+static int run(int n_blocks, double base)
+{
+	int ret = 0;
+	gating_t *exact = gating_create(GATING_MODE_EXACT);
+	gating_t *hist = gating_create(GATING_MODE_HISTOGRAM);
+
+	/* Integrated loudness: 100 ms step */
+	double walk = base;
+	for (int i = 0; i < n_blocks; i++) {
+		double e = gating_energy_from_lufs(next_lufs(&walk, base, i));
+		gating_add(exact, e);
+		gating_add(hist, e);
+	}
+
+	/* The histogram quantizes each block to 0.1 LU. */
+	ret |= check("integrated", gating_integrated(exact), gating_integrated(hist), 0.05);
+
+	gating_reset(exact);
+	gating_reset(hist);
+
+	/* Loudness range: 1 s step */
+	walk = base;
+	for (int i = 0; i < n_blocks / 10; i++) {
+		double e = gating_energy_from_lufs(next_lufs(&walk, base, i * 10));
+		gating_add(exact, e);
+		gating_add(hist, e);
+	}
+
+	ret |= check("range", gating_range(exact), gating_range(hist), 0.15);
+
+	gating_destroy(exact);
+	gating_destroy(hist);
+	return ret;
+}
+
+static int compare_double(const void *a, const void *b)
+{
+	const double x = *(const double *)a, y = *(const double *)b;
+	return (x > y) - (x < y);
+}
+
+/* The gates of BS.1770 and EBU Tech 3342 applied to a sorted copy of all the blocks */
+static void reference(const double *blocks, int n, double gate, double *integrated, double *range)
+{
+	double *sorted = malloc(sizeof(double) * (n ? n : 1));
+	int m = 0;
+	double sum = 0.0;
+	for (int i = 0; i < n; i++) {
+		if (blocks[i] >= gating_energy_from_lufs(-70.0)) {
+			sorted[m++] = blocks[i];
+			sum += blocks[i];
+		}
+	}
+	qsort(sorted, m, sizeof(double), compare_double);
+
+	const double threshold = m ? sum / m * gate : 0.0;
+	int start = 0;
+	while (start < m && sorted[start] < threshold)
+		start++;
+
+	double gated = 0.0;
+	for (int i = start; i < m; i++)
+		gated += sorted[i];
+	*integrated = start < m ? gating_lufs_from_energy(gated / (m - start)) : -HUGE_VAL;
+
+	*range = 0.0;
+	if (start < m) {
+		const int count = m - start;
+		const double low = sorted[start + (int)((count - 1) * 0.1 + 0.5)];
+		const double high = sorted[start + (int)((count - 1) * 0.95 + 0.5)];
+		*range = gating_lufs_from_energy(high) - gating_lufs_from_energy(low);
+	}
+
+	free(sorted);
+}
+
+static int run_reference(int n_blocks, double base)
+{
+	int ret = 0;
+	gating_t *g = gating_create(GATING_MODE_EXACT);
+	double *blocks = malloc(sizeof(double) * n_blocks);
+
+	double walk = base;
+	for (int i = 0; i < n_blocks; i++) {
+		blocks[i] = gating_energy_from_lufs(next_lufs(&walk, base, i));
+		gating_add(g, blocks[i]);
+	}
+
+	double integrated, range;
+	reference(blocks, n_blocks, 0.1, &integrated, &range);
+	ret |= check("reference I", integrated, gating_integrated(g), 1e-9);
+	reference(blocks, n_blocks, 0.01, &integrated, &range);
+	ret |= check("reference LRA", range, gating_range(g), 0.0);
+
+	free(blocks);
+	gating_destroy(g);
+	return ret;
+}
+
+static int run_snapshot(enum gating_mode mode, int n_blocks)
+{
+	int ret = 0;
+	gating_t *g = gating_create(mode);
+	gating_t *restored = gating_create(mode);
+	snapshot_buffer_t buf = {0};
+	snapshot_buffer_t journal = {0};
+
+	/* Saved twice as the snapshot thread does. The second save appends only the new blocks to the journal. */
+	double walk = -23.0;
+	for (int i = 0; i < n_blocks; i++) {
+		gating_add(g, gating_energy_from_lufs(next_lufs(&walk, -23.0, i)));
+		if (i == n_blocks / 2) {
+			gating_save(g, &buf, &journal, 0);
+			da_resize(buf, 0);
+		}
+	}
+	const size_t first_size = journal.num;
+	gating_save(g, &buf, &journal, 0);
+
+	const size_t appended = journal.num - first_size;
+	if (mode == GATING_MODE_EXACT && appended > sizeof(double) * (n_blocks - n_blocks / 2 - 1) + 8) {
+		printf("Error: %zu bytes appended to the journal for %d blocks\n", appended, n_blocks - n_blocks / 2 - 1);
+		ret = 1;
+	}
+
+	/* Leftover blocks have to be replaced. */
+	gating_add(restored, gating_energy_from_lufs(-10.0));
+
+	struct snapshot_reader r = {.data = buf.array, .size = buf.num};
+	struct snapshot_reader j = {.data = journal.array, .size = journal.num};
+	if (!gating_load(restored, &r, &j, 0) || r.pos != r.size) {
+		printf("Error: failed to load the snapshot of %d blocks\n", n_blocks);
+		ret = 1;
+	}
+	ret |= check("snapshot I", gating_integrated(g), gating_integrated(restored), 0.0);
+	ret |= check("snapshot LRA", gating_range(g), gating_range(restored), 0.0);
+
+	/* A truncated snapshot or journal is rejected and leaves the gating empty. */
+	r.pos = 0;
+	r.size = buf.num - 1;
+	if (gating_load(restored, &r, &j, 0) || gating_integrated(restored) != -HUGE_VAL) {
+		printf("Error: a truncated snapshot was loaded\n");
+		ret = 1;
+	}
+	if (mode == GATING_MODE_EXACT) {
+		r.pos = 0;
+		r.size = buf.num;
+		j.size = first_size;
+		if (gating_load(restored, &r, &j, 0) || gating_integrated(restored) != -HUGE_VAL) {
+			printf("Error: a truncated journal was loaded\n");
+			ret = 1;
+		}
+	}
+
+	da_free(buf);
+	da_free(journal);
+	gating_destroy(g);
+	gating_destroy(restored);
+	return ret;
+}
+
+int main()
+{
+	int ret = 0;
+
+	ret |= run(0, -23.0);
+	ret |= run(100, -23.0);
+	ret |= run(36000, -23.0);
+	ret |= run(36000 * 4, -16.0);
+
+	ret |= run_reference(100, -23.0);
+	ret |= run_reference(36000, -23.0);
+	ret |= run_reference(36000 * 4, -16.0);
+
+	ret |= run_snapshot(GATING_MODE_EXACT, 36000);
+	ret |= run_snapshot(GATING_MODE_HISTOGRAM, 36000);
+
+	return ret;
+}
@@ -0,0 +1,118 @@
+/*
+Loudness Dock for OBS Studio
+Copyright (C) 2025 Norihiro Kamae <norihiro@nagater.net>
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+/* Checks the segments, the range, the decimation, and the retention of `history_t`. */
+
+#include <stdio.h>
+#include <stdint.h>
+#include "history.h"
+
+#define START_MS 1000000
+
+static int expect(const char *what, long long value, long long expected)
+{
+	if (value == expected)
+		return 0;
+	printf("Error: %s: %lld, expected %lld\n", what, value, expected);
+	return 1;
+}
+
+/* Block `i` has the momentary loudness of -(i % 100) LUFS. */
+static void add_blocks(history_t *h, uint64_t start_ms, int first, int n)
+{
+	for (int i = first; i < first + n; i++) {
+		const uint64_t t = start_ms + (uint64_t)(i - first) * HISTORY_BLOCK_MS;
+		history_add(h, t, -(double)(i % 100), i < 30 ? -HUGE_VAL : -20.0, i == first);
+	}
+}
+
+int main()
+{
+	int ret = 0;
+	struct history_result r;
+
+	/* Two segments with a gap, crossing the chunks of 600 blocks */
+	history_t *h = history_create(3600);
+	add_blocks(h, START_MS, 0, 1500);
+	const uint64_t second = START_MS + 1500 * HISTORY_BLOCK_MS + 5000;
+	add_blocks(h, second, 1500, 200);
+
+	history_query(h, 0, UINT64_MAX, 1, &r);
+	ret |= expect("segments", (long long)r.n_segments, 2);
+	ret |= expect("values", (long long)r.n_values, 1700);
+	ret |= expect("1st start", (long long)r.segments[0].start_ms, START_MS);
+	ret |= expect("1st count", (long long)r.segments[0].count, 1500);
+	ret |= expect("2nd start", (long long)r.segments[1].start_ms, (long long)second);
+	ret |= expect("2nd offset", (long long)r.segments[1].offset, 1500);
+	ret |= expect("momentary[1234]", r.momentary[1234], -3400);
+	ret |= expect("short[0]", r.short_term[0], HISTORY_NO_VALUE);
+	ret |= expect("short[30]", r.short_term[30], -2000);
+	history_result_free(&r);
+
+	/* Range in the first segment */
+	history_query(h, START_MS + 1000, START_MS + 2000, 1, &r);
+	ret |= expect("range segments", (long long)r.n_segments, 1);
+	ret |= expect("range values", (long long)r.n_values, 10);
+	ret |= expect("range momentary[0]", r.momentary[0], -1000);
+	history_result_free(&r);
+
+	/* Decimated by 10, aligned to 1 s, keeping the loudest */
+	history_query(h, 0, START_MS + 1500 * HISTORY_BLOCK_MS, 10, &r);
+	ret |= expect("decimated interval", r.interval_ms, 1000);
+	ret |= expect("decimated values", (long long)r.n_values, 150);
+	ret |= expect("decimated start", (long long)r.segments[0].start_ms, START_MS + 900);
+	ret |= expect("decimated momentary[1]", r.momentary[1], -1000);
+	history_result_free(&r);
+	history_destroy(h);
+
+	/* The clock of the audio is slower by 0.1 %. The drift reaches a block at the third minute. */
+	h = history_create(3600);
+	for (int i = 0; i < 1800; i++)
+		history_add(h, START_MS + (uint64_t)i * 1001 / 10, -20.0, -20.0, i == 0);
+	history_query(h, 0, UINT64_MAX, 1, &r);
+	ret |= expect("drift values", (long long)r.n_values, 1800);
+	ret |= expect("drift segments", (long long)r.n_segments, 2);
+	ret |= expect("drift 1st count", (long long)r.segments[0].count, 1200);
+	ret |= expect("drift 2nd start", (long long)r.segments[1].start_ms, START_MS + 1200 * 1001 / 10);
+	history_result_free(&r);
+	history_destroy(h);
+
+	/* A jitter less than a block keeps the segment. */
+	h = history_create(3600);
+	for (int i = 0; i < 1200; i++)
+		history_add(h, START_MS + (uint64_t)i * HISTORY_BLOCK_MS + (i >= 600 ? 50 : 0), -20.0, -20.0, i == 0);
+	history_query(h, 0, UINT64_MAX, 1, &r);
+	ret |= expect("jitter segments", (long long)r.n_segments, 1);
+	ret |= expect("jitter values", (long long)r.n_values, 1200);
+	history_result_free(&r);
+	history_destroy(h);
+
+	/* The oldest chunks are recycled. */
+	h = history_create(120);
+	add_blocks(h, START_MS, 0, 6000);
+	history_query(h, 0, UINT64_MAX, 1, &r);
+	ret |= expect("retention segments", (long long)r.n_segments, 1);
+	ret |= expect("retention values", (long long)r.n_values, 1800);
+	ret |= expect("retention start", (long long)r.segments[0].start_ms, START_MS + 4200 * HISTORY_BLOCK_MS);
+	history_result_free(&r);
+	history_destroy(h);
+
+	printf("%s\n", ret ? "failed" : "ok");
+	return ret;
+}
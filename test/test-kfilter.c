@@ -0,0 +1,124 @@
+/*
+Loudness Dock for OBS Studio
+Copyright (C) 2025 Norihiro Kamae <norihiro@nagater.net>
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+/* Checks the precomputed coefficients and that the vectorized K-weighting kernels are bit-exact to the scalar
+ * reference. */
+
+#include <stdio.h>
+#include <math.h>
+#include <string.h>
+#include <stdint.h>
+#include "kfilter.h"
+
+#define FRAMES 4800
+#define MAX_CH 8
+
+static uint32_t rand_state = 1;
+
+static float rand_sample(void)
+{
+	rand_state = rand_state * 1103515245u + 12345u;
+	return (float)(rand_state >> 8) / (float)(1u << 23) - 1.0f;
+}
+
+static int run(enum kfilter_kernel kernel, uint32_t n_ch, double samplerate)
+{
+	static float buf[MAX_CH][FRAMES];
+	const float *in[MAX_CH];
+	struct kfilter_coeffs k;
+	struct kfilter_state ref[MAX_CH], vec[MAX_CH];
+	struct kfilter_state *vec_p[MAX_CH];
+	double ref_sums[MAX_CH], vec_sums[MAX_CH];
+
+	kfilter_init_coeffs(&k, samplerate);
+	memset(ref, 0, sizeof(ref));
+	memset(vec, 0, sizeof(vec));
+	for (uint32_t ch = 0; ch < n_ch; ch++) {
+		in[ch] = buf[ch];
+		vec_p[ch] = &vec[ch];
+	}
+
+	kfilter_set_kernel(kernel);
+
+	/* Several calls with odd lengths so that the state is carried over. */
+	for (size_t pos = 0, n = 1; pos < FRAMES; pos += n, n = n * 3 + 7) {
+		if (pos + n > FRAMES)
+			n = FRAMES - pos;
+		for (uint32_t ch = 0; ch < n_ch; ch++) {
+			for (size_t i = 0; i < n; i++)
+				buf[ch][i] = rand_sample() * (float)(ch + 1) / MAX_CH;
+			ref_sums[ch] = kfilter_process(&k, &ref[ch], in[ch], n);
+		}
+		kfilter_process_channels(&k, vec_p, in, n_ch, n, vec_sums);
+
+		for (uint32_t ch = 0; ch < n_ch; ch++) {
+			if (ref_sums[ch] != vec_sums[ch] || memcmp(&ref[ch], &vec[ch], sizeof(ref[ch]))) {
+				printf("Error: kernel=%s channels=%u samplerate=%.0f ch=%u pos=%zu: %.17g != %.17g\n",
+				       kfilter_kernel_name(kernel), n_ch, samplerate, ch, pos, vec_sums[ch],
+				       ref_sums[ch]);
+				return 1;
+			}
+		}
+	}
+
+	return 0;
+}
+
+static int check_precomputed(double samplerate)
+{
+	struct kfilter_coeffs k, computed;
+	kfilter_init_coeffs(&k, samplerate);
+	kfilter_compute_coeffs(&computed, samplerate);
+
+	for (int i = 0; i < 5; i++) {
+		if (fabs(k.a[i] - computed.a[i]) > 1e-14 * fabs(computed.a[i]) ||
+		    fabs(k.b[i] - computed.b[i]) > 1e-14 * fabs(computed.b[i])) {
+			printf("Error: samplerate=%.0f coefficient %d: a=%.17g b=%.17g, computed a=%.17g b=%.17g\n",
+			       samplerate, i, k.a[i], k.b[i], computed.a[i], computed.b[i]);
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+int main()
+{
+	int ret = 0;
+
+	ret |= check_precomputed(44100.0);
+	ret |= check_precomputed(48000.0);
+
+	for (int kernel = KFILTER_KERNEL_SCALAR; kernel <= KFILTER_KERNEL_AVX2; kernel++) {
+		if (!kfilter_kernel_supported(kernel)) {
+			printf("kernel %s: not supported, skipped\n", kfilter_kernel_name(kernel));
+			continue;
+		}
+		int r = 0;
+		for (uint32_t n_ch = 1; n_ch <= MAX_CH; n_ch++) {
+			r |= run(kernel, n_ch, 48000.0);
+			r |= run(kernel, n_ch, 44100.0);
+			r |= run(kernel, n_ch, 96000.0);
+		}
+		printf("kernel %s: %s\n", kfilter_kernel_name(kernel), r ? "failed" : "ok");
+		ret |= r;
+	}
+
+	return ret;
+}
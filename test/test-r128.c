@@ -0,0 +1,247 @@
+/*
+Loudness Dock for OBS Studio
+Copyright (C) 2025 Norihiro Kamae <norihiro@nagater.net>
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+/* Checks the calibration and the channel weights of the planar front-end `r128_t`.
+ * If built with libebur128, also compares `r128_t` against libebur128 fed with the interleaved frames. */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <math.h>
+#ifdef HAVE_LIBEBUR128
+#include <ebur128.h>
+#endif
+#include "r128.h"
+#include "kfilter.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define PACKET_FRAMES 1024
+
+static double lufs(double energy)
+{
+	return energy > 0.0 ? 10.0 * log10(energy) - 0.691 : -HUGE_VAL;
+}
+
+static int compare(const char *what, double ref, double dut, double tolerance)
+{
+	if (ref == dut)
+		return 0;
+	if (fabs(ref - dut) <= tolerance)
+		return 0;
+	printf("Error: %s: expected=%f r128=%f\n", what, ref, dut);
+	return 1;
+}
+
+/* Feeds `seconds` of a 1 kHz sine of -20 dBFS to the channels in `mask` and returns the short-term loudness. */
+static double sine_loudness(uint32_t channels, uint32_t mask, int seconds)
+{
+	r128_t *r = r128_create(channels, 48000);
+	struct r128_history h;
+	r128_history_reset(&h);
+	static float sine[4800];
+	static float silence[4800];
+	for (int i = 0; i < 4800; i++)
+		sine[i] = (float)(0.1 * sin(2.0 * M_PI * 1000.0 * i / 48000.0));
+
+	const float *in[R128_MAX_CHANNELS];
+	for (uint32_t ch = 0; ch < channels; ch++)
+		in[ch] = (mask & (1u << ch)) ? sine : silence;
+
+	for (int k = 0; k < seconds * 10; k++) {
+		bool block_completed = false;
+		struct r128_block block;
+		r128_add_planar(r, in, 4800, &block, &block_completed);
+		if (block_completed)
+			r128_history_add(&h, block.energy);
+	}
+
+	r128_destroy(r);
+	return lufs(r128_history_energy(&h, R128_SHORT_TERM_BLOCKS));
+}
+
+/* The weights of the default channel map of libebur128 for each number of the channels.
+ * OBS orders the channels as FL, FR, FC, LFE, RL, RR, SL, SR for 5.1 and 7.1,
+ * but 4.0 is FL, FR, FC, RC and 4.1 is FL, FR, FC, LFE, RC. */
+static const double channel_weights[R128_MAX_CHANNELS + 1][R128_MAX_CHANNELS] = {
+	[1] = {1.0},
+	[2] = {1.0, 1.0},
+	[3] = {1.0, 1.0, 1.0},
+	[4] = {1.0, 1.0, 1.41, 1.41},
+	[5] = {1.0, 1.0, 1.0, 1.41, 1.41},
+	[6] = {1.0, 1.0, 1.0, 0.0, 1.41, 1.41},
+	[7] = {1.0, 1.0, 1.0, 0.0, 1.41, 1.41, 0.0},
+	[8] = {1.0, 1.0, 1.0, 0.0, 1.41, 1.41, 0.0, 0.0},
+};
+
+static int run_weights(uint32_t channels)
+{
+	int ret = 0;
+	for (uint32_t ch = 0; ch < channels; ch++) {
+		/* A sine of -20 dBFS on one channel of weight 1.0 reads -23 LUFS. */
+		const double w = channel_weights[channels][ch];
+		const double expected = w > 0.0 ? -23.0 + 10.0 * log10(w) : -HUGE_VAL;
+		char what[32];
+		snprintf(what, sizeof(what), "weight %u/%u", ch, channels);
+		ret |= compare(what, expected, sine_loudness(channels, 1u << ch, 3), 0.05);
+	}
+	printf("channels=%u weights %s\n", channels, ret ? "NG" : "OK");
+	return ret;
+}
+
+#ifdef HAVE_LIBEBUR128
+static uint32_t rand_state = 1;
+
+static float rand_noise(void)
+{
+	rand_state = rand_state * 1103515245u + 12345u;
+	return (float)(rand_state >> 8) / (float)(1u << 23) - 1.0f;
+}
+
+/* Generates a sine on the first channels and noise on the others, with the level changing every second. */
+static void generate(float planes[][PACKET_FRAMES], uint32_t channels, uint32_t samplerate, uint64_t t0)
+{
+	for (uint32_t i = 0; i < PACKET_FRAMES; i++) {
+		uint64_t t = t0 + i;
+		double gain = pow(10.0, -(double)((t / samplerate) % 40) / 20.0);
+		for (uint32_t ch = 0; ch < channels; ch++) {
+			if (ch < 2)
+				planes[ch][i] = (float)(gain * sin(2.0 * M_PI * 997.0 * (double)t / samplerate));
+			else
+				planes[ch][i] = (float)(gain * 0.5) * rand_noise();
+		}
+	}
+}
+
+static int run(uint32_t channels, uint32_t samplerate, uint32_t seconds)
+{
+	int ret = 0;
+	int mode = EBUR128_MODE_M | EBUR128_MODE_S | EBUR128_MODE_TRUE_PEAK;
+	ebur128_state *ref = ebur128_init(channels, samplerate, mode);
+	r128_t *dut = r128_create(channels, samplerate);
+	const enum r128_peak tp = r128_peak_for_factor(samplerate, 4);
+	r128_set_peaks(dut, R128_PEAK_BIT(tp));
+	struct r128_history history;
+	r128_history_reset(&history);
+	float dut_peak = 0.0f;
+
+	static float planes[R128_MAX_CHANNELS][PACKET_FRAMES];
+	static float interleaved[R128_MAX_CHANNELS * PACKET_FRAMES];
+	const float *in[R128_MAX_CHANNELS];
+
+	uint64_t t = 0;
+	uint32_t n_blocks = 0;
+	const size_t samples_in_100ms = (samplerate + 5) / 10;
+	size_t frames_in_block = 0;
+
+	while (t < (uint64_t)samplerate * seconds) {
+		generate(planes, channels, samplerate, t);
+		t += PACKET_FRAMES;
+
+		size_t done = 0;
+		while (done < PACKET_FRAMES) {
+			for (uint32_t ch = 0; ch < channels; ch++)
+				in[ch] = planes[ch] + done;
+
+			bool block_completed = false;
+			struct r128_block block;
+			size_t n = r128_add_planar(dut, in, PACKET_FRAMES - done, &block, &block_completed);
+
+			/* Feed libebur128 the same span so that both can be compared at the block boundary. */
+			for (size_t i = 0; i < n; i++) {
+				for (uint32_t ch = 0; ch < channels; ch++)
+					interleaved[i * channels + ch] = in[ch][i];
+			}
+			ebur128_add_frames_float(ref, interleaved, n);
+			done += n;
+			frames_in_block += n;
+
+			if (!block_completed)
+				continue;
+
+			if (frames_in_block != samples_in_100ms) {
+				printf("Error: block completed after %zu frames\n", frames_in_block);
+				ret = 1;
+			}
+			frames_in_block = 0;
+			n_blocks++;
+			r128_history_add(&history, block.energy);
+			if (block.peak[tp] > dut_peak)
+				dut_peak = block.peak[tp];
+
+			double m, s;
+			ebur128_loudness_momentary(ref, &m);
+			ebur128_loudness_shortterm(ref, &s);
+			ret |= compare("momentary", m, lufs(r128_history_energy(&history, R128_MOMENTARY_BLOCKS)), 1e-6);
+			ret |= compare("short-term", s, lufs(r128_history_energy(&history, R128_SHORT_TERM_BLOCKS)), 1e-6);
+
+			double peak = 0.0;
+			for (uint32_t ch = 0; ch < channels; ch++) {
+				double p;
+				if (ebur128_true_peak(ref, ch, &p) == 0 && p > peak)
+					peak = p;
+			}
+			ret |= compare("peak", peak, dut_peak, 1e-7);
+
+			if (ret)
+				break;
+		}
+		if (ret)
+			break;
+	}
+
+	printf("channels=%u samplerate=%u blocks=%u %s\n", channels, samplerate, n_blocks, ret ? "NG" : "OK");
+
+	r128_destroy(dut);
+	ebur128_destroy(&ref);
+	return ret;
+}
+#endif
+
+int main()
+{
+	int ret = 0;
+
+	printf("K-weighting kernel: %s\n", kfilter_kernel_name(kfilter_select_kernel()));
+
+	/* A sine of -20 dBFS on both channels of stereo reads -20 LUFS. */
+	double s = sine_loudness(2, 3, 3);
+	printf("1 kHz -20 dBFS: %f LUFS\n", s);
+	ret |= compare("calibration", -20.0, s, 0.05);
+
+	for (uint32_t channels = 1; channels <= R128_MAX_CHANNELS; channels++)
+		ret |= run_weights(channels);
+
+#ifdef HAVE_LIBEBUR128
+	ret |= run(1, 48000, 10);
+	ret |= run(2, 48000, 60);
+	ret |= run(2, 44100, 60);
+	ret |= run(3, 48000, 10);
+	ret |= run(4, 48000, 10);
+	ret |= run(5, 48000, 10);
+	ret |= run(6, 48000, 30);
+	ret |= run(8, 48000, 30);
+	ret |= run(2, 96000, 10);
+#else
+	printf("Built without libebur128. Skipped the comparison against libebur128.\n");
+#endif
+
+	return ret;
+}
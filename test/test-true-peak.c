@@ -0,0 +1,109 @@
+/*
+Loudness Dock for OBS Studio
+Copyright (C) 2025 Norihiro Kamae <norihiro@nagater.net>
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+/* Checks the vectorized and the specialized true-peak kernels are bit-exact to the scalar reference. */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "true-peak.h"
+#include "kfilter.h"
+
+#define FRAMES 4800
+#define MAX_CH 8
+
+static uint32_t rand_state = 1;
+
+static float rand_sample(void)
+{
+	rand_state = rand_state * 1103515245u + 12345u;
+	return (float)(rand_state >> 8) / (float)(1u << 23) - 1.0f;
+}
+
+static int run(enum kfilter_kernel kernel, uint32_t n_ch, uint32_t factor, bool fixed)
+{
+	static float buf[MAX_CH][FRAMES];
+	const float *in[MAX_CH];
+	struct true_peak_filter f;
+	struct true_peak_state ref[MAX_CH], vec[MAX_CH];
+	struct true_peak_state *vec_p[MAX_CH];
+	float ref_peaks[MAX_CH], vec_peaks[MAX_CH];
+
+	true_peak_init_filter(&f, factor);
+	if (fixed && f.fixed_factor != factor) {
+		printf("Error: factor=%u is not specialized\n", factor);
+		return 1;
+	}
+	if (!fixed)
+		f.fixed_factor = 0;
+	memset(ref, 0, sizeof(ref));
+	memset(vec, 0, sizeof(vec));
+	for (uint32_t ch = 0; ch < n_ch; ch++) {
+		in[ch] = buf[ch];
+		vec_p[ch] = &vec[ch];
+	}
+
+	kfilter_set_kernel(kernel);
+
+	for (size_t pos = 0, n = 1; pos < FRAMES; pos += n, n = n * 3 + 7) {
+		if (pos + n > FRAMES)
+			n = FRAMES - pos;
+		for (uint32_t ch = 0; ch < n_ch; ch++) {
+			for (size_t i = 0; i < n; i++)
+				buf[ch][i] = rand_sample() * (float)(ch + 1) / MAX_CH;
+			ref_peaks[ch] = true_peak_process(&f, &ref[ch], in[ch], n);
+		}
+		true_peak_process_channels(&f, vec_p, in, n_ch, n, vec_peaks);
+
+		for (uint32_t ch = 0; ch < n_ch; ch++) {
+			if (ref_peaks[ch] != vec_peaks[ch] || memcmp(&ref[ch], &vec[ch], sizeof(ref[ch]))) {
+				printf("Error: kernel=%s%s channels=%u factor=%u ch=%u pos=%zu: %.9g != %.9g\n",
+				       kfilter_kernel_name(kernel), fixed ? " fixed" : "", n_ch, factor, ch, pos,
+				       vec_peaks[ch], ref_peaks[ch]);
+				return 1;
+			}
+		}
+	}
+
+	return 0;
+}
+
+int main()
+{
+	int ret = 0;
+
+	for (int kernel = KFILTER_KERNEL_SCALAR; kernel <= KFILTER_KERNEL_AVX2; kernel++) {
+		if (!kfilter_kernel_supported(kernel)) {
+			printf("kernel %s: not supported, skipped\n", kfilter_kernel_name(kernel));
+			continue;
+		}
+		int r = 0;
+		for (uint32_t n_ch = 1; n_ch <= MAX_CH; n_ch++) {
+			for (int fixed = 0; fixed <= 1; fixed++) {
+				r |= run(kernel, n_ch, 2, fixed);
+				r |= run(kernel, n_ch, 4, fixed);
+			}
+		}
+		printf("kernel %s: %s\n", kfilter_kernel_name(kernel), r ? "failed" : "ok");
+		ret |= r;
+	}
+
+	return ret;
+}
@@ -21,6 +21,7 @@ class MyOBSWSClient:
         self.last_exceed = None
         self.args = args
         self.obsws = None
+        self.event = None
 
     async def ws_connect(self):
         'Connect to obs-websocket'
@@ -30,6 +31,7 @@ class MyOBSWSClient:
                     password=self.args.obsws_passwd)
             await obsws.connect()
             await obsws.wait_until_identified()
+            obsws.register_event_callback(self.on_vendor_event, 'VendorEvent')
             self.obsws = obsws
         except:
             print(f'Info: {self.args.obsws}: Connection failed. Will retry later')
@@ -51,52 +53,79 @@ class MyOBSWSClient:
 
             retry -= 1
 
-    async def check_alert_cond(self):
+    async def on_vendor_event(self, data):
+        'Keep the latest loudness event'
+        if data['vendorName'] == 'loudness-dock' and data['eventType'] == 'loudness':
+            self.event = data['eventData']
+
+    async def subscribe(self):
+        'Request the loudness events, also renews the subscription before it expires'
+        await self.ws_send_request(
+                'CallVendorRequest',
+                {
+                    'vendorName': 'loudness-dock',
+                    'requestType': 'subscribe',
+                    'requestData': {
+                        'id': 'dd_loudness_watch',
+                        'interval_ms': int(self.args.interval * 1000),
+                    }
+                })
+
+    def check_alert_cond(self, event):
         '''
         Check the condition for if_streaming and if_recording
         If both if_streaming and if_recording are set,
         the alert is disabled only if both streaming and recording are inactive.
         '''
 
-        if self.args.if_streaming:
-            res = await self.ws_send_request('GetStreamStatus')
-            if res and res['outputActive']:
-                return True
+        if self.args.if_streaming and event['streaming']:
+            return True
 
-        if self.args.if_recording:
-            res = await self.ws_send_request('GetRecordStatus')
-            if res and res['outputActive']:
-                return True
+        if self.args.if_recording and event['recording']:
+            return True
 
         if self.args.if_streaming or self.args.if_recording:
             return False
 
         return True
 
+    def find_tab(self, event):
+        'Returns the tab to watch'
+        tabs = event['tabs']
+        if self.args.name is not None:
+            for tab in tabs:
+                if tab['name'] == self.args.name:
+                    return tab
+            return None
+        if 0 <= event['current'] < len(tabs):
+            return tabs[event['current']]
+        return None
+
     async def run_loudness_watcher(self, cb):
         'A loop method checking the loudness'
 
         time_threshold = timedelta(seconds=self.args.wait_time)
-
-        if not self.obsws:
-            await self.ws_connect()
+        last_subscribed = None
 
         while True:
-            await asyncio.sleep(3)
+            if not last_subscribed or datetime.now() - last_subscribed > timedelta(seconds=10):
+                await self.subscribe()
+                last_subscribed = datetime.now()
+
+            await asyncio.sleep(self.args.interval)
+
+            event = self.event
+            self.event = None
+            if not event:
+                continue
 
-            if not await self.check_alert_cond():
+            if not self.check_alert_cond(event):
                 self.last_exceed = datetime.now()
                 continue
 
-            res = await self.ws_send_request(
-                    'CallVendorRequest',
-                    {
-                        'vendorName': 'loudness-dock',
-                        'requestType': 'get_loudness',
-                        'requestData': {}
-                    })
-            if res:
-                short_lufs = res['responseData']['short']
+            tab = self.find_tab(event)
+            if tab and 'short' in tab:
+                short_lufs = tab['short']
 
                 too_low = False
                 low_duration_s = 0
@@ -246,6 +275,10 @@ def get_args():
                         help='obs-websocket host and port, separated by colon(:)')
     parser.add_argument('--obsws-passwd', action='store', default=None,
                         help='Password for obs-websocket')
+    parser.add_argument('--interval', action='store', type=float, default=3.0,
+                        help='Interval in second of the loudness events')
+    parser.add_argument('--name', action='store', default=None,
+                        help='Name of the tab to watch, the current tab if not set')
 
     # arguments for loudness check
     parser.add_argument('--threshold', action='store', type=float, default=-36.0,